@@ -3,4 +3,7 @@ cd build
 mkdir Shader
 cd ..
 glslc.exe Shader/Shader.vert -o build/Shader/Vert.spv
-glslc.exe Shader/Shader.frag -o build/Shader/Frag.spv
\ No newline at end of file
+glslc.exe Shader/Shader.frag -o build/Shader/Frag.spv
+glslc.exe -DBINDLESS Shader/Shader.frag -o build/Shader/FragBindless.spv
+glslc.exe -DPARAMETER_BLOCK Shader/Shader.frag -o build/Shader/FragBlock.spv
+glslc.exe -DBINDLESS -DPARAMETER_BLOCK Shader/Shader.frag -o build/Shader/FragBindlessBlock.spv
\ No newline at end of file
@@ -1,9 +1,71 @@
 #version 450
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+#ifdef PARAMETER_BLOCK
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference_uvec2 : require
+#endif
 
 layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
+// Shadertoy style inputs, the FrameUniforms struct of SeVulkanWindow
+layout(set = 0, binding = 0) uniform FrameUniforms {
+    vec4 resolution;
+    vec4 mouse;
+    float time;
+    float time_delta;
+    uint frame;
+    uint padding;
+    vec4 parameters[2];
+} frame;
+
+#ifdef PARAMETER_BLOCK
+// Set through setParameterBlock() or setParameterAddress(), the address is
+// zero without one
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer ParameterBlock {
+    vec4 tint;
+};
+#endif
+
+// The PushConstants struct of SeVulkanWindow
+layout(push_constant) uniform PushConstants {
+    layout(offset = 0) uint accumulated_samples;
+    layout(offset = 4) uint channels[4];
+#ifdef PARAMETER_BLOCK
+    layout(offset = 24) uvec2 parameters;
+#endif
+} push;
+
+#ifdef BINDLESS
+const uint INVALID_HANDLE = 0xFFFFFFFFu;
+
+// Binding 0 of the bindless table, indexed with the channel handles
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+vec4 sampleChannel(uint channel, vec2 uv) {
+    uint handle = push.channels[channel];
+    // Unbound channels read as transparent black
+    if (handle == INVALID_HANDLE) {
+        return vec4(0.0);
+    }
+    return texture(textures[nonuniformEXT(handle)], uv);
+}
+#endif
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
-}
\ No newline at end of file
+    vec3 color = fragColor;
+#ifdef BINDLESS
+    vec2 uv = gl_FragCoord.xy / frame.resolution.xy;
+    vec4 channel0 = sampleChannel(0, uv);
+    color = mix(color, channel0.rgb, channel0.a);
+#endif
+#ifdef PARAMETER_BLOCK
+    if (any(notEqual(push.parameters, uvec2(0)))) {
+        color *= ParameterBlock(push.parameters).tint.rgb;
+    }
+#endif
+    outColor = vec4(color, 1.0);
+}
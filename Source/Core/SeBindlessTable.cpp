@@ -0,0 +1,186 @@
+#include "SeBindlessTable.h"
+#include <QDebug>
+#include <algorithm>
+
+#pragma region Init and cleanup
+SeBindlessTable::SeBindlessTable() {
+}
+
+SeBindlessTable::~SeBindlessTable() {
+    cleanup();
+}
+
+void SeBindlessTable::init(VkDevice device, SeDescriptorLayoutCache *layout_cache, SeDeletionQueue *deletion_queue, const VkPhysicalDeviceDescriptorIndexingPropertiesEXT &properties) {
+    assert(device != VK_NULL_HANDLE && layout_cache != nullptr && deletion_queue != nullptr);
+    m_device = device;
+    m_deletion_queue = deletion_queue;
+
+    // Both arrays are visible to the fragment stage, so they share its
+    // update after bind resource budget. Combined image samplers count as
+    // samplers as well as sampled images
+    m_images.capacity = std::min({MAX_IMAGES, properties.maxDescriptorSetUpdateAfterBindSampledImages, properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                  properties.maxDescriptorSetUpdateAfterBindSamplers, properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+    m_buffers.capacity = std::min({MAX_BUFFERS, properties.maxDescriptorSetUpdateAfterBindStorageBuffers, properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+    uint32_t resource_budget = properties.maxPerStageUpdateAfterBindResources;
+    if (m_images.capacity + m_buffers.capacity > resource_budget) {
+        m_buffers.capacity = std::min(m_buffers.capacity, resource_budget / 4);
+        m_images.capacity = std::min(m_images.capacity, resource_budget - m_buffers.capacity);
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0].binding = IMAGE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = m_images.capacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[1].binding = BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = m_buffers.capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+    m_set_layout = layout_cache->layout(bindings, {binding_flags, binding_flags}, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT);
+
+    VkDescriptorPoolSize pool_sizes[] = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_images.capacity},
+                                         {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_buffers.capacity}};
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+
+    VkResult result;
+    result = vkCreateDescriptorPool(m_device, &pool_info, nullptr, &m_descriptor_pool);
+    assert(result == VK_SUCCESS);
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = m_descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &m_set_layout;
+    result = vkAllocateDescriptorSets(m_device, &alloc_info, &m_descriptor_set);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Bindless table created with" << m_images.capacity << "images and" << m_buffers.capacity << "buffers";
+    } else {
+        qDebug() << "Failed to allocate bindless set!";
+    }
+    assert(result == VK_SUCCESS);
+}
+
+void SeBindlessTable::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    // The layout belongs to the cache
+    vkDestroyDescriptorPool(m_device, m_descriptor_pool, nullptr);
+    m_descriptor_pool = VK_NULL_HANDLE;
+    m_descriptor_set = VK_NULL_HANDLE;
+    m_set_layout = VK_NULL_HANDLE;
+    m_images = Slots{};
+    m_buffers = Slots{};
+    m_deletion_queue = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+bool SeBindlessTable::isInitialized() const {
+    return m_device != VK_NULL_HANDLE;
+}
+
+VkDescriptorSetLayout SeBindlessTable::setLayout() const {
+    return m_set_layout;
+}
+
+VkDescriptorSet SeBindlessTable::descriptorSet() const {
+    return m_descriptor_set;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Slots
+SeBindlessTable::Handle SeBindlessTable::Slots::acquire() {
+    Handle handle = INVALID_HANDLE;
+    if (!free_handles.empty()) {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    } else if (next < capacity) {
+        handle = next++;
+    }
+    if (handle != INVALID_HANDLE) {
+        live++;
+    }
+    return handle;
+}
+
+SeBindlessTable::Handle SeBindlessTable::addImage(VkImageView view, VkSampler sampler, VkImageLayout layout) {
+    Handle handle = m_images.acquire();
+    if (handle == INVALID_HANDLE) {
+        qDebug() << "Bindless image slots exhausted!";
+        return INVALID_HANDLE;
+    }
+    updateImage(handle, view, sampler, layout);
+    return handle;
+}
+
+void SeBindlessTable::updateImage(Handle handle, VkImageView view, VkSampler sampler, VkImageLayout layout) {
+    // Only valid for slots no pending command buffer reads, which holds for
+    // fresh slots and for ones whose previous contents were never drawn
+    assert(handle < m_images.next);
+    VkDescriptorImageInfo image_info{};
+    image_info.sampler = sampler;
+    image_info.imageView = view;
+    image_info.imageLayout = layout;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_descriptor_set;
+    write.dstBinding = IMAGE_BINDING;
+    write.dstArrayElement = handle;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+}
+
+void SeBindlessTable::removeImage(Handle handle, uint64_t last_use_frame_number) {
+    assert(handle < m_images.next);
+    m_images.live--;
+    m_deletion_queue->retire(last_use_frame_number, [this, handle]() { m_images.free_handles.push_back(handle); });
+}
+
+SeBindlessTable::Handle SeBindlessTable::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    Handle handle = m_buffers.acquire();
+    if (handle == INVALID_HANDLE) {
+        qDebug() << "Bindless buffer slots exhausted!";
+        return INVALID_HANDLE;
+    }
+    VkDescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_descriptor_set;
+    write.dstBinding = BUFFER_BINDING;
+    write.dstArrayElement = handle;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+    return handle;
+}
+
+void SeBindlessTable::removeBuffer(Handle handle, uint64_t last_use_frame_number) {
+    assert(handle < m_buffers.next);
+    m_buffers.live--;
+    m_deletion_queue->retire(last_use_frame_number, [this, handle]() { m_buffers.free_handles.push_back(handle); });
+}
+
+uint32_t SeBindlessTable::imageCount() const {
+    return m_images.live;
+}
+
+uint32_t SeBindlessTable::bufferCount() const {
+    return m_buffers.live;
+}
+
+#pragma endregion Slots
@@ -0,0 +1,69 @@
+#ifndef SE_BINDLESS_TABLE_H
+#define SE_BINDLESS_TABLE_H
+
+#include "SeDeletionQueue.h"
+#include "SeDescriptorLayoutCache.h"
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// One descriptor set holding a large array per resource type, bound once
+// for every pass: binding 0 is an array of combined image samplers and
+// binding 1 an array of storage buffers. Shaders index the arrays with the
+// handles they get through push constants, so adding a texture neither
+// allocates a set nor changes a pipeline layout. The set is created with
+// update after bind and partially bound bindings, which lets slots be
+// written while command buffers that use other slots are still pending.
+// A removed slot is only reused once every frame that could read it has
+// completed. Needs descriptor indexing.
+class SeBindlessTable {
+  public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+    SeBindlessTable();
+    ~SeBindlessTable();
+
+    void init(VkDevice device, SeDescriptorLayoutCache *layout_cache, SeDeletionQueue *deletion_queue, const VkPhysicalDeviceDescriptorIndexingPropertiesEXT &properties);
+    void cleanup();
+    bool isInitialized() const;
+
+    VkDescriptorSetLayout setLayout() const;
+    VkDescriptorSet descriptorSet() const;
+
+    Handle addImage(VkImageView view, VkSampler sampler, VkImageLayout layout);
+    void updateImage(Handle handle, VkImageView view, VkSampler sampler, VkImageLayout layout);
+    void removeImage(Handle handle, uint64_t last_use_frame_number);
+    Handle addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+    void removeBuffer(Handle handle, uint64_t last_use_frame_number);
+    uint32_t imageCount() const;
+    uint32_t bufferCount() const;
+
+  private:
+    static constexpr uint32_t MAX_IMAGES = 16384;
+    static constexpr uint32_t MAX_BUFFERS = 4096;
+    static constexpr uint32_t IMAGE_BINDING = 0;
+    static constexpr uint32_t BUFFER_BINDING = 1;
+
+    struct Slots {
+        uint32_t capacity = 0;
+        uint32_t next = 0;
+        uint32_t live = 0;
+        std::vector<Handle> free_handles;
+
+        Handle acquire();
+    };
+
+    SeBindlessTable(const SeBindlessTable &) = delete;
+    SeBindlessTable &operator=(const SeBindlessTable &) = delete;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    SeDeletionQueue *m_deletion_queue = nullptr;
+    VkDescriptorSetLayout m_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_descriptor_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_descriptor_set = VK_NULL_HANDLE;
+    Slots m_images;
+    Slots m_buffers;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "SeDeletionQueue.h"
+#include <cassert>
+
+SeDeletionQueue::~SeDeletionQueue() {
+    // flush() has to run while the device is still alive
+    assert(m_retired_objects.empty());
+}
+
+void SeDeletionQueue::setCompletionQuery(CompletionQuery &&completion_query) {
+    m_completion_query = std::move(completion_query);
+}
+
+void SeDeletionQueue::retire(uint64_t frame_number, Deleter &&deleter) {
+    // Frame numbers only grow, so the queue stays sorted
+    assert(m_retired_objects.empty() || m_retired_objects.back().frame_number <= frame_number);
+    m_retired_objects.push_back({frame_number, std::move(deleter)});
+}
+
+void SeDeletionQueue::collect(uint64_t completed_frame_number) {
+    while (!m_retired_objects.empty() && m_retired_objects.front().frame_number <= completed_frame_number) {
+        m_retired_objects.front().deleter();
+        m_retired_objects.pop_front();
+    }
+}
+
+void SeDeletionQueue::collectCompleted() {
+    // Never blocks, the query only reports frames already seen complete
+    if (m_completion_query && !m_retired_objects.empty()) {
+        collect(m_completion_query());
+    }
+}
+
+void SeDeletionQueue::flush() {
+    for (auto &retired_object : m_retired_objects) {
+        retired_object.deleter();
+    }
+    m_retired_objects.clear();
+}
+
+size_t SeDeletionQueue::pendingCount() const {
+    return m_retired_objects.size();
+}
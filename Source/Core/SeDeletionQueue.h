@@ -0,0 +1,38 @@
+#ifndef SE_DELETION_QUEUE_H
+#define SE_DELETION_QUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// Defers the destruction of Vulkan objects that may still be referenced by
+// frames in flight. Objects retired while frame N is the latest submitted
+// frame are destroyed once frame N is known to have completed, so pipelines,
+// swap chains and images can be replaced without draining the GPU. Objects
+// retired outside the owner's frame loop, e.g. by an eviction during another
+// window's frame, are collected right away through the completion query.
+class SeDeletionQueue {
+  public:
+    using Deleter = std::function<void()>;
+    using CompletionQuery = std::function<uint64_t()>;
+
+    ~SeDeletionQueue();
+
+    void setCompletionQuery(CompletionQuery &&completion_query);
+    void retire(uint64_t frame_number, Deleter &&deleter);
+    void collect(uint64_t completed_frame_number);
+    void collectCompleted();
+    void flush();
+    size_t pendingCount() const;
+
+  private:
+    struct RetiredObject {
+        uint64_t frame_number;
+        Deleter deleter;
+    };
+
+    std::deque<RetiredObject> m_retired_objects;
+    CompletionQuery m_completion_query;
+};
+
+#endif
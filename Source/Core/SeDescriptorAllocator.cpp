@@ -0,0 +1,147 @@
+#include "SeDescriptorAllocator.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+#pragma region Init and cleanup
+SeDescriptorAllocator::SeDescriptorAllocator() {
+}
+
+SeDescriptorAllocator::~SeDescriptorAllocator() {
+    cleanup();
+}
+
+void SeDescriptorAllocator::init(VkDevice device, SeDescriptorLayoutCache *layout_cache, uint32_t frame_count) {
+    assert(device != VK_NULL_HANDLE && layout_cache != nullptr && frame_count > 0);
+    m_device = device;
+    m_layout_cache = layout_cache;
+    m_frame_pools.resize(frame_count);
+    m_current_frame = 0;
+}
+
+void SeDescriptorAllocator::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    // The caller has waited for the device to become idle
+    for (auto &pool_list : m_frame_pools) {
+        destroyPools(pool_list);
+    }
+    destroyPools(m_persistent_pools);
+    m_frame_pools.clear();
+    m_layout_cache = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+void SeDescriptorAllocator::destroyPools(PoolList &pool_list) {
+    for (auto pool : pool_list.pools) {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    pool_list.pools.clear();
+    pool_list.usage = Usage{};
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Pools
+void SeDescriptorAllocator::Usage::add(const std::vector<VkDescriptorPoolSize> &counts) {
+    set_count++;
+    for (const auto &count : counts) {
+        auto itr = std::find_if(descriptor_counts.begin(), descriptor_counts.end(), [&count](const VkDescriptorPoolSize &size) { return size.type == count.type; });
+        if (itr != descriptor_counts.end()) {
+            itr->descriptorCount += count.descriptorCount;
+        } else {
+            descriptor_counts.push_back(count);
+        }
+    }
+}
+
+VkDescriptorPool SeDescriptorAllocator::createPool(const Usage &usage, float scale) const {
+    uint32_t max_sets = std::max(MIN_POOL_SETS, static_cast<uint32_t>(std::ceil(usage.set_count * scale)));
+    std::vector<VkDescriptorPoolSize> pool_sizes = usage.descriptor_counts;
+    for (auto &pool_size : pool_sizes) {
+        pool_size.descriptorCount = std::max(MIN_POOL_SETS, static_cast<uint32_t>(std::ceil(pool_size.descriptorCount * scale)));
+    }
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = max_sets;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkResult result;
+    result = vkCreateDescriptorPool(m_device, &pool_info, nullptr, &pool);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create descriptor pool!";
+    }
+    assert(result == VK_SUCCESS);
+    return pool;
+}
+
+size_t SeDescriptorAllocator::poolCount() const {
+    size_t count = m_persistent_pools.pools.size();
+    for (const auto &pool_list : m_frame_pools) {
+        count += pool_list.pools.size();
+    }
+    return count;
+}
+
+#pragma endregion Pools
+
+#pragma region Allocation
+void SeDescriptorAllocator::beginFrame(uint32_t frame_index) {
+    assert(frame_index < m_frame_pools.size());
+    m_current_frame = frame_index;
+    PoolList &pool_list = m_frame_pools[frame_index];
+
+    // The frame's fence has signaled, so none of its sets is in use anymore
+    if (pool_list.pools.size() > 1) {
+        // The frame outgrew its pool, fold everything it needed into one
+        Usage usage = pool_list.usage;
+        destroyPools(pool_list);
+        pool_list.pools.push_back(createPool(usage, FOLD_HEADROOM));
+        qDebug() << "Descriptor pools of frame" << frame_index << "folded for" << usage.set_count << "sets";
+    } else if (!pool_list.pools.empty()) {
+        vkResetDescriptorPool(m_device, pool_list.pools.front(), 0);
+    }
+    pool_list.usage = Usage{};
+}
+
+VkDescriptorSet SeDescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    return allocate(m_frame_pools[m_current_frame], layout);
+}
+
+VkDescriptorSet SeDescriptorAllocator::allocatePersistent(VkDescriptorSetLayout layout) {
+    return allocate(m_persistent_pools, layout);
+}
+
+VkDescriptorSet SeDescriptorAllocator::allocate(PoolList &pool_list, VkDescriptorSetLayout layout) {
+    assert(m_device != VK_NULL_HANDLE);
+    pool_list.usage.add(m_layout_cache->descriptorCounts(layout));
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+    VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+    if (!pool_list.pools.empty()) {
+        alloc_info.descriptorPool = pool_list.pools.back();
+        result = vkAllocateDescriptorSets(m_device, &alloc_info, &descriptor_set);
+    }
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        // Twice what was used so far, so a growing frame needs few pools
+        pool_list.pools.push_back(createPool(pool_list.usage, 2.0f));
+        alloc_info.descriptorPool = pool_list.pools.back();
+        result = vkAllocateDescriptorSets(m_device, &alloc_info, &descriptor_set);
+    }
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to allocate descriptor set: " << result;
+    }
+    assert(result == VK_SUCCESS);
+    return descriptor_set;
+}
+
+#pragma endregion Allocation
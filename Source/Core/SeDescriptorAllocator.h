@@ -0,0 +1,62 @@
+#ifndef SE_DESCRIPTOR_ALLOCATOR_H
+#define SE_DESCRIPTOR_ALLOCATOR_H
+
+#include "SeDescriptorLayoutCache.h"
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Allocates descriptor sets from pools sized by observed usage instead of
+// fixed guesses. Transient sets come from the pools of the current frame in
+// flight, which are reset wholesale once the frame's fence has signaled, so
+// no set is ever freed individually. When a frame runs out, another pool
+// twice the size used so far is added, and at the next reset the frame's
+// pools are folded into a single one that fits the whole frame. Persistent
+// sets come from separate pools that grow the same way and are only
+// released by cleanup(). Used from the GUI thread only, so sets have to be
+// allocated before recording is spread over worker threads.
+class SeDescriptorAllocator {
+  public:
+    SeDescriptorAllocator();
+    ~SeDescriptorAllocator();
+
+    void init(VkDevice device, SeDescriptorLayoutCache *layout_cache, uint32_t frame_count);
+    void cleanup();
+
+    void beginFrame(uint32_t frame_index);
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    VkDescriptorSet allocatePersistent(VkDescriptorSetLayout layout);
+    size_t poolCount() const;
+
+  private:
+    static constexpr uint32_t MIN_POOL_SETS = 16;
+    // Headroom when a frame's pools are folded into one
+    static constexpr float FOLD_HEADROOM = 1.25f;
+
+    struct Usage {
+        uint32_t set_count = 0;
+        std::vector<VkDescriptorPoolSize> descriptor_counts;
+
+        void add(const std::vector<VkDescriptorPoolSize> &counts);
+    };
+
+    struct PoolList {
+        std::vector<VkDescriptorPool> pools;
+        Usage usage;
+    };
+
+    SeDescriptorAllocator(const SeDescriptorAllocator &) = delete;
+    SeDescriptorAllocator &operator=(const SeDescriptorAllocator &) = delete;
+
+    VkDescriptorSet allocate(PoolList &pool_list, VkDescriptorSetLayout layout);
+    VkDescriptorPool createPool(const Usage &usage, float scale) const;
+    void destroyPools(PoolList &pool_list);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    SeDescriptorLayoutCache *m_layout_cache = nullptr;
+    std::vector<PoolList> m_frame_pools;
+    PoolList m_persistent_pools;
+    uint32_t m_current_frame = 0;
+};
+
+#endif
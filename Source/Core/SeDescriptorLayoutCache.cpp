@@ -0,0 +1,143 @@
+#include "SeDescriptorLayoutCache.h"
+#include <QDebug>
+#include <algorithm>
+
+#pragma region Init and cleanup
+SeDescriptorLayoutCache::SeDescriptorLayoutCache() {
+}
+
+SeDescriptorLayoutCache::~SeDescriptorLayoutCache() {
+    cleanup();
+}
+
+void SeDescriptorLayoutCache::init(VkDevice device) {
+    assert(device != VK_NULL_HANDLE);
+    m_device = device;
+}
+
+void SeDescriptorLayoutCache::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    for (auto &entry : m_layouts) {
+        vkDestroyDescriptorSetLayout(m_device, entry.second, nullptr);
+    }
+    if (!m_layouts.empty()) {
+        qDebug() << "Descriptor layout cache destroyed" << m_layouts.size() << "layouts";
+    }
+    m_layouts.clear();
+    m_descriptor_counts.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Signatures
+bool SeDescriptorLayoutCache::Signature::operator==(const Signature &other) const {
+    if (flags != other.flags || bindings.size() != other.bindings.size() || binding_flags != other.binding_flags) {
+        return false;
+    }
+    for (size_t i = 0; i < bindings.size(); i++) {
+        const VkDescriptorSetLayoutBinding &a = bindings[i];
+        const VkDescriptorSetLayoutBinding &b = other.bindings[i];
+        if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t SeDescriptorLayoutCache::SignatureHash::operator()(const Signature &signature) const {
+    uint64_t hash = signature.flags;
+    auto combine = [&hash](uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    };
+    for (const auto &binding : signature.bindings) {
+        combine(binding.binding);
+        combine(static_cast<uint64_t>(binding.descriptorType));
+        combine(binding.descriptorCount);
+        combine(binding.stageFlags);
+    }
+    for (auto binding_flags : signature.binding_flags) {
+        combine(binding_flags);
+    }
+    return static_cast<size_t>(hash);
+}
+
+#pragma endregion Signatures
+
+#pragma region Layouts
+VkDescriptorSetLayout SeDescriptorLayoutCache::layout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags) {
+    return layout(std::move(bindings), {}, flags);
+}
+
+VkDescriptorSetLayout SeDescriptorLayoutCache::layout(std::vector<VkDescriptorSetLayoutBinding> bindings, std::vector<VkDescriptorBindingFlags> binding_flags, VkDescriptorSetLayoutCreateFlags flags) {
+    assert(m_device != VK_NULL_HANDLE);
+    assert(binding_flags.empty() || binding_flags.size() == bindings.size());
+    // Binding order does not change the layout, so it must not change the key
+    std::vector<size_t> order(bindings.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&bindings](size_t a, size_t b) { return bindings[a].binding < bindings[b].binding; });
+
+    Signature signature;
+    signature.flags = flags;
+    for (auto i : order) {
+        // Immutable samplers would have to be part of the signature
+        assert(bindings[i].pImmutableSamplers == nullptr);
+        signature.bindings.push_back(bindings[i]);
+        if (!binding_flags.empty()) {
+            signature.binding_flags.push_back(binding_flags[i]);
+        }
+    }
+    auto itr = m_layouts.find(signature);
+    if (itr != m_layouts.end()) {
+        return itr->second;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    binding_flags_info.bindingCount = static_cast<uint32_t>(signature.binding_flags.size());
+    binding_flags_info.pBindingFlags = signature.binding_flags.data();
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.pNext = signature.binding_flags.empty() ? nullptr : &binding_flags_info;
+    layout_info.flags = flags;
+    layout_info.bindingCount = static_cast<uint32_t>(signature.bindings.size());
+    layout_info.pBindings = signature.bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkResult result;
+    result = vkCreateDescriptorSetLayout(m_device, &layout_info, nullptr, &layout);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create descriptor set layout!";
+    }
+    assert(result == VK_SUCCESS);
+
+    std::vector<VkDescriptorPoolSize> counts;
+    for (const auto &binding : signature.bindings) {
+        auto count = std::find_if(counts.begin(), counts.end(), [&binding](const VkDescriptorPoolSize &size) { return size.type == binding.descriptorType; });
+        if (count != counts.end()) {
+            count->descriptorCount += binding.descriptorCount;
+        } else {
+            counts.push_back({binding.descriptorType, binding.descriptorCount});
+        }
+    }
+    m_descriptor_counts[layout] = std::move(counts);
+    m_layouts.emplace(std::move(signature), layout);
+    return layout;
+}
+
+const std::vector<VkDescriptorPoolSize> &SeDescriptorLayoutCache::descriptorCounts(VkDescriptorSetLayout layout) const {
+    auto itr = m_descriptor_counts.find(layout);
+    assert(itr != m_descriptor_counts.end());
+    return itr->second;
+}
+
+size_t SeDescriptorLayoutCache::layoutCount() const {
+    return m_layouts.size();
+}
+
+#pragma endregion Layouts
@@ -0,0 +1,49 @@
+#ifndef SE_DESCRIPTOR_LAYOUT_CACHE_H
+#define SE_DESCRIPTOR_LAYOUT_CACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Maps binding signatures to shared descriptor set layouts, so identical
+// layouts requested by different windows, passes or pipelines are created
+// once and compare equal by handle. The cache also remembers how many
+// descriptors of each type a layout holds, which is what descriptor pools
+// are sized by. Layouts live until cleanup(). Used from the GUI thread only.
+class SeDescriptorLayoutCache {
+  public:
+    SeDescriptorLayoutCache();
+    ~SeDescriptorLayoutCache();
+
+    void init(VkDevice device);
+    void cleanup();
+
+    VkDescriptorSetLayout layout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+    // Binding flags in the order of the bindings, needs descriptor indexing
+    VkDescriptorSetLayout layout(std::vector<VkDescriptorSetLayoutBinding> bindings, std::vector<VkDescriptorBindingFlags> binding_flags, VkDescriptorSetLayoutCreateFlags flags);
+    const std::vector<VkDescriptorPoolSize> &descriptorCounts(VkDescriptorSetLayout layout) const;
+    size_t layoutCount() const;
+
+  private:
+    struct Signature {
+        VkDescriptorSetLayoutCreateFlags flags = 0;
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        std::vector<VkDescriptorBindingFlags> binding_flags;
+
+        bool operator==(const Signature &other) const;
+    };
+
+    struct SignatureHash {
+        size_t operator()(const Signature &signature) const;
+    };
+
+    SeDescriptorLayoutCache(const SeDescriptorLayoutCache &) = delete;
+    SeDescriptorLayoutCache &operator=(const SeDescriptorLayoutCache &) = delete;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    std::unordered_map<Signature, VkDescriptorSetLayout, SignatureHash> m_layouts;
+    std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorPoolSize>> m_descriptor_counts;
+};
+
+#endif
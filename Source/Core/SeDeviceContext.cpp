@@ -0,0 +1,497 @@
+#include "SeDeviceContext.h"
+#include "SeVulkanManager.h"
+#include <QDebug>
+#include <set>
+
+#pragma region Init and cleanup
+SeDeviceContext::SeDeviceContext() {
+}
+
+SeDeviceContext::~SeDeviceContext() {
+    cleanup();
+}
+
+void SeDeviceContext::init(SeVulkanManager *vulkan_manager, VkSurfaceKHR surface) {
+    assert(m_device == VK_NULL_HANDLE && vulkan_manager != nullptr);
+    m_vulkan_manager = vulkan_manager;
+    m_physical_device = m_vulkan_manager->getBestDevice(surface, m_device_extensions);
+    if (m_physical_device == VK_NULL_HANDLE) {
+        // Stays uninitialized, the caller decides what to do without a device
+        return;
+    }
+    createLogicalDevice(surface);
+    createPipelineCache();
+    m_memory_allocator.init(m_physical_device, m_device, m_buffer_device_address_supported, m_memory_budget_supported);
+    m_residency_manager.init(&m_memory_allocator);
+    m_descriptor_layout_cache.init(m_device);
+    m_upload_ring.init(m_device, &m_memory_allocator, m_transfer_queue, transferFamily(), transferGranularity(), m_queue_family_indices.graphic_family.value());
+}
+
+void SeDeviceContext::cleanup() {
+    if (m_device) {
+        vkDeviceWaitIdle(m_device);
+        m_memory_allocator.printStats();
+    }
+    m_upload_ring.cleanup();
+    m_descriptor_layout_cache.cleanup();
+    m_residency_manager.cleanup();
+    m_memory_allocator.cleanup();
+    destroyPipelineCache();
+    destroyLogicalDevice();
+    m_physical_device = VK_NULL_HANDLE;
+    m_users.clear();
+    m_device_lost = false;
+    m_frame_users.clear();
+    m_frame_number = 0;
+}
+
+bool SeDeviceContext::isInitialized() const {
+    return m_device != VK_NULL_HANDLE;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Users
+void SeDeviceContext::addUser(const void *user, DeviceLostHandler &&device_lost_handler) {
+    assert(isInitialized() && m_users.find(user) == m_users.end());
+    m_users[user] = std::move(device_lost_handler);
+}
+
+void SeDeviceContext::removeUser(const void *user) {
+    m_users.erase(user);
+    m_frame_users.erase(user);
+}
+
+bool SeDeviceContext::hasUser(const void *user) const {
+    return m_users.find(user) != m_users.end();
+}
+
+size_t SeDeviceContext::userCount() const {
+    return m_users.size();
+}
+
+void SeDeviceContext::markDeviceLost() {
+    if (m_device_lost) {
+        return;
+    }
+    // Every window holds objects of the lost device and has to release them
+    // before the device can be recreated. The handlers release them right
+    // away and leave, only the window that saw the loss stays a user until
+    // its next frame, so the context outlives this loop
+    m_device_lost = true;
+    std::vector<DeviceLostHandler> handlers;
+    for (auto &user : m_users) {
+        handlers.push_back(user.second);
+    }
+    for (auto &handler : handlers) {
+        handler();
+    }
+}
+
+bool SeDeviceContext::isDeviceLost() const {
+    return m_device_lost;
+}
+
+uint64_t SeDeviceContext::beginFrame(const void *user) {
+    // A device frame ends when a window starts its next frame, so it spans
+    // one frame of every window that is drawing and idle windows add nothing
+    if (m_frame_users.count(user) > 0) {
+        m_frame_number++;
+        m_frame_users.clear();
+    }
+    m_frame_users.insert(user);
+    return m_frame_number;
+}
+
+#pragma endregion Users
+
+#pragma region Logical device
+void SeDeviceContext::createLogicalDevice(VkSurfaceKHR surface) {
+    assert(m_physical_device != VK_NULL_HANDLE);
+
+    SeQueueFamilyIndices queue_family_indices = m_vulkan_manager->findQueueFamilies(m_physical_device, surface);
+
+    std::vector<VkDeviceQueueCreateInfo> device_queue_create_infos;
+    std::set<uint32_t> queue_families = {queue_family_indices.graphic_family.value(), queue_family_indices.present_family.value()};
+    if (queue_family_indices.compute_family.has_value()) {
+        queue_families.insert(queue_family_indices.compute_family.value());
+    }
+    if (queue_family_indices.transfer_family.has_value()) {
+        queue_families.insert(queue_family_indices.transfer_family.value());
+    }
+    float queue_priority = 1.0f;
+    for (auto queue_family : queue_families) {
+        VkDeviceQueueCreateInfo device_queue_create_info{};
+        device_queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        device_queue_create_info.queueCount = 1;
+        device_queue_create_info.queueFamilyIndex = queue_family;
+        device_queue_create_info.pQueuePriorities = &queue_priority;
+        device_queue_create_info.pNext = nullptr;
+        device_queue_create_info.flags = 0;
+        device_queue_create_infos.push_back(device_queue_create_info);
+    }
+
+    m_enabled_device_extensions = m_device_extensions;
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(m_physical_device, &device_properties);
+    m_device_api_version = device_properties.apiVersion;
+
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features{};
+    dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features{};
+    synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features{};
+    descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR buffer_device_address_features{};
+    buffer_device_address_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+
+    // Feature and property chains are core in 1.1, a 1.0 device gets none of
+    // the optional features
+    bool features2_supported = m_device_api_version >= VK_API_VERSION_1_1;
+    bool present_timing_extensions = features2_supported && m_vulkan_manager->checkDeviceExtensionSupport(m_physical_device, m_present_timing_extensions);
+    bool dynamic_rendering_core = m_device_api_version >= VK_API_VERSION_1_3;
+    bool dynamic_rendering_extension = !dynamic_rendering_core && m_device_api_version >= VK_API_VERSION_1_2 && m_vulkan_manager->checkDeviceExtensionSupport(m_physical_device, {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME});
+    bool synchronization2_extension = !dynamic_rendering_core && m_device_api_version >= VK_API_VERSION_1_1 && m_vulkan_manager->checkDeviceExtensionSupport(m_physical_device, {VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME});
+    bool descriptor_indexing_core = m_device_api_version >= VK_API_VERSION_1_2;
+    bool descriptor_indexing_extension = !descriptor_indexing_core && m_device_api_version >= VK_API_VERSION_1_1 && m_vulkan_manager->checkDeviceExtensionSupport(m_physical_device, {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME});
+    bool buffer_device_address_core = descriptor_indexing_core;
+    bool buffer_device_address_extension = !buffer_device_address_core && m_device_api_version >= VK_API_VERSION_1_1 && m_vulkan_manager->checkDeviceExtensionSupport(m_physical_device, {VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME});
+    // Only adds a properties struct, there is no feature to query
+    m_memory_budget_supported = m_device_api_version >= VK_API_VERSION_1_1 && m_vulkan_manager->checkDeviceExtensionSupport(m_physical_device, {VK_EXT_MEMORY_BUDGET_EXTENSION_NAME});
+
+    // Optional features are queried through one features2 chain first, then
+    // only the ones actually used are chained again into the create info
+    VkPhysicalDeviceFeatures2 device_features2{};
+    device_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    auto chainFeatures = [&device_features2](auto &features) {
+        features.pNext = device_features2.pNext;
+        device_features2.pNext = &features;
+    };
+    if (present_timing_extensions) {
+        chainFeatures(present_id_features);
+        chainFeatures(present_wait_features);
+    }
+    if (dynamic_rendering_core || dynamic_rendering_extension) {
+        chainFeatures(dynamic_rendering_features);
+    }
+    if (dynamic_rendering_core || synchronization2_extension) {
+        chainFeatures(synchronization2_features);
+    }
+    if (descriptor_indexing_core || descriptor_indexing_extension) {
+        chainFeatures(descriptor_indexing_features);
+    }
+    if (buffer_device_address_core || buffer_device_address_extension) {
+        chainFeatures(buffer_device_address_features);
+    }
+    if (features2_supported) {
+        vkGetPhysicalDeviceFeatures2(m_physical_device, &device_features2);
+    }
+
+    m_present_timing_supported = present_timing_extensions && present_id_features.presentId && present_wait_features.presentWait;
+    m_dynamic_rendering_supported = dynamic_rendering_features.dynamicRendering == VK_TRUE;
+    bool synchronization2_supported = synchronization2_features.synchronization2 == VK_TRUE;
+    // Bindless needs runtime sized arrays that are indexed per pixel, only
+    // partially written and updated while command buffers are pending
+    m_descriptor_indexing_supported = (descriptor_indexing_core || descriptor_indexing_extension) && descriptor_indexing_features.runtimeDescriptorArray &&
+                                      descriptor_indexing_features.descriptorBindingPartiallyBound && descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing &&
+                                      descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind && descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind;
+    m_buffer_device_address_supported = (buffer_device_address_core || buffer_device_address_extension) && buffer_device_address_features.bufferDeviceAddress;
+
+    // Core features stay disabled unless a later pass needs them
+    device_features2.pNext = nullptr;
+    device_features2.features = VkPhysicalDeviceFeatures{};
+    if (m_present_timing_supported) {
+        m_enabled_device_extensions.insert(m_enabled_device_extensions.end(), m_present_timing_extensions.begin(), m_present_timing_extensions.end());
+        chainFeatures(present_id_features);
+        chainFeatures(present_wait_features);
+    } else {
+        qDebug() << "Present timing not supported, frame pacing disabled";
+    }
+    if (m_dynamic_rendering_supported) {
+        if (dynamic_rendering_extension) {
+            m_enabled_device_extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        }
+        chainFeatures(dynamic_rendering_features);
+        qDebug() << "Dynamic rendering enabled";
+    }
+    if (synchronization2_supported) {
+        if (synchronization2_extension) {
+            m_enabled_device_extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        }
+        chainFeatures(synchronization2_features);
+    }
+    if (m_descriptor_indexing_supported) {
+        if (descriptor_indexing_extension) {
+            m_enabled_device_extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
+        chainFeatures(descriptor_indexing_features);
+
+        m_descriptor_indexing_properties = VkPhysicalDeviceDescriptorIndexingPropertiesEXT{};
+        m_descriptor_indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 device_properties2{};
+        device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        device_properties2.pNext = &m_descriptor_indexing_properties;
+        vkGetPhysicalDeviceProperties2(m_physical_device, &device_properties2);
+        m_descriptor_indexing_properties.pNext = nullptr;
+        qDebug() << "Descriptor indexing enabled";
+    }
+    if (m_buffer_device_address_supported) {
+        if (buffer_device_address_extension) {
+            m_enabled_device_extensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+        }
+        // Capture replay and multi device addresses are never needed
+        buffer_device_address_features.bufferDeviceAddressCaptureReplay = VK_FALSE;
+        buffer_device_address_features.bufferDeviceAddressMultiDevice = VK_FALSE;
+        chainFeatures(buffer_device_address_features);
+        qDebug() << "Buffer device address enabled";
+    }
+    if (m_memory_budget_supported) {
+        m_enabled_device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        qDebug() << "Memory budget enabled";
+    } else {
+        qDebug() << "Memory budget not supported, heap usage is estimated";
+    }
+
+    VkDeviceCreateInfo device_create_info{};
+    device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_create_info.pNext = features2_supported ? &device_features2 : nullptr;
+    device_create_info.pQueueCreateInfos = device_queue_create_infos.data();
+    device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_families.size());
+    device_create_info.pEnabledFeatures = features2_supported ? nullptr : &device_features2.features;
+    device_create_info.enabledExtensionCount = static_cast<uint32_t>(m_enabled_device_extensions.size());
+    device_create_info.ppEnabledExtensionNames = m_enabled_device_extensions.data();
+    device_create_info.enabledLayerCount = 0;
+    VkResult result = vkCreateDevice(m_physical_device, &device_create_info, nullptr, &m_device);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Logical device created";
+    } else {
+        qDebug() << "Failed to create logical device!";
+    }
+    assert(result == VK_SUCCESS);
+
+    m_queue_family_indices = queue_family_indices;
+    for (auto queue_family : queue_families) {
+        VkQueue queue = VK_NULL_HANDLE;
+        vkGetDeviceQueue(m_device, queue_family, 0, &queue);
+        m_queues[queue_family] = queue;
+    }
+    m_graphics_queue = m_queues[queue_family_indices.graphic_family.value()];
+    // Without a dedicated family compute work simply stays on the graphics
+    // queue. Transfers fall back to the compute queue instead: an async
+    // compute family can copy too and still keeps uploads off the queue
+    // that draws, and it is the graphics queue itself when there is none
+    m_compute_queue = queue_family_indices.compute_family.has_value() ? m_queues[queue_family_indices.compute_family.value()] : m_graphics_queue;
+    m_transfer_queue = queue_family_indices.transfer_family.has_value() ? m_queues[queue_family_indices.transfer_family.value()] : m_compute_queue;
+    qDebug() << "Queue families: graphics" << queue_family_indices.graphic_family.value() << "present" << queue_family_indices.present_family.value()
+             << "compute" << (queue_family_indices.compute_family.has_value() ? QString::number(queue_family_indices.compute_family.value()) : QString("shared"))
+             << "transfer" << (queue_family_indices.transfer_family.has_value() ? QString::number(queue_family_indices.transfer_family.value()) : QString("shared"));
+
+    if (m_present_timing_supported) {
+        m_vkWaitForPresentKHR = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR"));
+        m_present_timing_supported = m_vkWaitForPresentKHR != nullptr;
+    }
+    if (m_dynamic_rendering_supported) {
+        const char *begin_name = dynamic_rendering_core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR";
+        const char *end_name = dynamic_rendering_core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR";
+        m_vkCmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(m_device, begin_name));
+        m_vkCmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(m_device, end_name));
+        m_dynamic_rendering_supported = m_vkCmdBeginRendering != nullptr && m_vkCmdEndRendering != nullptr;
+    }
+    if (synchronization2_supported) {
+        const char *barrier_name = dynamic_rendering_core ? "vkCmdPipelineBarrier2" : "vkCmdPipelineBarrier2KHR";
+        m_vkCmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(m_device, barrier_name));
+    }
+    if (m_buffer_device_address_supported) {
+        const char *address_name = buffer_device_address_core ? "vkGetBufferDeviceAddress" : "vkGetBufferDeviceAddressKHR";
+        m_vkGetBufferDeviceAddress = reinterpret_cast<PFN_vkGetBufferDeviceAddressKHR>(vkGetDeviceProcAddr(m_device, address_name));
+        m_buffer_device_address_supported = m_vkGetBufferDeviceAddress != nullptr;
+    }
+}
+
+void SeDeviceContext::destroyLogicalDevice() {
+    if (m_device) {
+        vkDestroyDevice(m_device, nullptr);
+        m_vkWaitForPresentKHR = nullptr;
+        m_vkCmdBeginRendering = nullptr;
+        m_vkCmdEndRendering = nullptr;
+        m_vkCmdPipelineBarrier2 = nullptr;
+        m_present_timing_supported = false;
+        m_dynamic_rendering_supported = false;
+        m_descriptor_indexing_supported = false;
+        m_buffer_device_address_supported = false;
+        m_vkGetBufferDeviceAddress = nullptr;
+        m_memory_budget_supported = false;
+        m_queues.clear();
+        m_graphics_queue = VK_NULL_HANDLE;
+        m_compute_queue = VK_NULL_HANDLE;
+        m_transfer_queue = VK_NULL_HANDLE;
+        m_device = VK_NULL_HANDLE;
+        qDebug() << "Logical device destoryed";
+    }
+}
+
+bool SeDeviceContext::supportsSurface(VkSurfaceKHR surface) const {
+    // Later windows can only use the device if it presents to their surface
+    // from a queue family that has a queue
+    if (!m_vulkan_manager->isDeviceSuitable(m_physical_device, surface, m_device_extensions)) {
+        return false;
+    }
+    SeQueueFamilyIndices indices = m_vulkan_manager->findQueueFamilies(m_physical_device, surface);
+    return m_queues.find(indices.present_family.value()) != m_queues.end();
+}
+
+VkQueue SeDeviceContext::queue(uint32_t queue_family_index) const {
+    auto itr = m_queues.find(queue_family_index);
+    return itr != m_queues.end() ? itr->second : VK_NULL_HANDLE;
+}
+
+#pragma endregion Logical device
+
+#pragma region Pipeline cache
+void SeDeviceContext::createPipelineCache() {
+    // Shared so a shader compiled for one window is not compiled again for
+    // the next one
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    VkResult result;
+    result = vkCreatePipelineCache(m_device, &cache_info, nullptr, &m_pipeline_cache);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Pipeline cache created";
+    } else {
+        qDebug() << "Failed to create pipeline cache!";
+    }
+    assert(result == VK_SUCCESS);
+}
+
+void SeDeviceContext::destroyPipelineCache() {
+    if (m_pipeline_cache) {
+        vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
+        m_pipeline_cache = VK_NULL_HANDLE;
+    }
+}
+
+#pragma endregion Pipeline cache
+
+#pragma region Accessors
+VkPhysicalDevice SeDeviceContext::physicalDevice() const {
+    return m_physical_device;
+}
+
+VkDevice SeDeviceContext::device() const {
+    return m_device;
+}
+
+const SeQueueFamilyIndices &SeDeviceContext::queueFamilyIndices() const {
+    return m_queue_family_indices;
+}
+
+VkQueue SeDeviceContext::graphicsQueue() const {
+    return m_graphics_queue;
+}
+
+VkQueue SeDeviceContext::computeQueue() const {
+    return m_compute_queue;
+}
+
+uint32_t SeDeviceContext::computeFamily() const {
+    return m_queue_family_indices.compute_family.value_or(m_queue_family_indices.graphic_family.value());
+}
+
+VkQueue SeDeviceContext::transferQueue() const {
+    return m_transfer_queue;
+}
+
+uint32_t SeDeviceContext::transferFamily() const {
+    return m_queue_family_indices.transfer_family.value_or(computeFamily());
+}
+
+VkExtent3D SeDeviceContext::transferGranularity() const {
+    // Families with graphics or compute always report 1x1x1, dedicated
+    // transfer families may need coarser copies or whole mip levels
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physical_device, &queue_family_count, queue_families.data());
+    return queue_families[transferFamily()].minImageTransferGranularity;
+}
+
+VkPipelineCache SeDeviceContext::pipelineCache() const {
+    return m_pipeline_cache;
+}
+
+SeMemoryAllocator *SeDeviceContext::memoryAllocator() {
+    return &m_memory_allocator;
+}
+
+SeResidencyManager *SeDeviceContext::residencyManager() {
+    return &m_residency_manager;
+}
+
+SeUploadRing *SeDeviceContext::uploadRing() {
+    return &m_upload_ring;
+}
+
+SeDescriptorLayoutCache *SeDeviceContext::descriptorLayoutCache() {
+    return &m_descriptor_layout_cache;
+}
+
+bool SeDeviceContext::isPresentTimingSupported() const {
+    return m_present_timing_supported;
+}
+
+PFN_vkWaitForPresentKHR SeDeviceContext::waitForPresent() const {
+    return m_vkWaitForPresentKHR;
+}
+
+bool SeDeviceContext::isDynamicRenderingSupported() const {
+    return m_dynamic_rendering_supported;
+}
+
+PFN_vkCmdBeginRenderingKHR SeDeviceContext::cmdBeginRendering() const {
+    return m_vkCmdBeginRendering;
+}
+
+PFN_vkCmdEndRenderingKHR SeDeviceContext::cmdEndRendering() const {
+    return m_vkCmdEndRendering;
+}
+
+PFN_vkCmdPipelineBarrier2KHR SeDeviceContext::cmdPipelineBarrier2() const {
+    return m_vkCmdPipelineBarrier2;
+}
+
+bool SeDeviceContext::isDescriptorIndexingSupported() const {
+    return m_descriptor_indexing_supported;
+}
+
+const VkPhysicalDeviceDescriptorIndexingPropertiesEXT &SeDeviceContext::descriptorIndexingProperties() const {
+    return m_descriptor_indexing_properties;
+}
+
+bool SeDeviceContext::isBufferDeviceAddressSupported() const {
+    return m_buffer_device_address_supported;
+}
+
+bool SeDeviceContext::isMemoryBudgetSupported() const {
+    return m_memory_budget_supported;
+}
+
+PFN_vkGetBufferDeviceAddressKHR SeDeviceContext::getBufferDeviceAddress() const {
+    return m_vkGetBufferDeviceAddress;
+}
+
+VkDeviceAddress SeDeviceContext::bufferDeviceAddress(VkBuffer buffer) const {
+    // Buffers need VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    assert(m_buffer_device_address_supported);
+    VkBufferDeviceAddressInfoKHR address_info{};
+    address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+    address_info.buffer = buffer;
+    return m_vkGetBufferDeviceAddress(m_device, &address_info);
+}
+
+#pragma endregion Accessors
@@ -0,0 +1,121 @@
+#ifndef SE_DEVICE_CONTEXT_H
+#define SE_DEVICE_CONTEXT_H
+
+#include "SeDescriptorLayoutCache.h"
+#include "SeMemoryAllocator.h"
+#include "SeQueueFamilyIndices.h"
+#include "SeResidencyManager.h"
+#include "SeUploadRing.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class SeVulkanManager;
+
+// The logical device, its queues and the caches built on top of it, shared
+// by every preview window that can present from it. Windows only own their
+// surface and swap chain and register as users; the device is created for
+// the first user's surface and destroyed when the last user leaves. Queues
+// are submitted to from the GUI thread only, so they need no further
+// synchronization.
+class SeDeviceContext {
+  public:
+    using DeviceLostHandler = std::function<void()>;
+
+    SeDeviceContext();
+    ~SeDeviceContext();
+
+    void init(SeVulkanManager *vulkan_manager, VkSurfaceKHR surface);
+    void cleanup();
+    bool isInitialized() const;
+
+    void addUser(const void *user, DeviceLostHandler &&device_lost_handler);
+    void removeUser(const void *user);
+    bool hasUser(const void *user) const;
+    size_t userCount() const;
+    void markDeviceLost();
+    bool isDeviceLost() const;
+    uint64_t beginFrame(const void *user);
+
+    bool supportsSurface(VkSurfaceKHR surface) const;
+    VkQueue queue(uint32_t queue_family_index) const;
+
+    VkPhysicalDevice physicalDevice() const;
+    VkDevice device() const;
+    const SeQueueFamilyIndices &queueFamilyIndices() const;
+    VkQueue graphicsQueue() const;
+    VkQueue computeQueue() const;
+    uint32_t computeFamily() const;
+    VkQueue transferQueue() const;
+    uint32_t transferFamily() const;
+    VkExtent3D transferGranularity() const;
+    VkPipelineCache pipelineCache() const;
+    SeMemoryAllocator *memoryAllocator();
+    SeResidencyManager *residencyManager();
+    SeUploadRing *uploadRing();
+    SeDescriptorLayoutCache *descriptorLayoutCache();
+
+    bool isPresentTimingSupported() const;
+    PFN_vkWaitForPresentKHR waitForPresent() const;
+    bool isDynamicRenderingSupported() const;
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering() const;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering() const;
+    PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2() const;
+    bool isDescriptorIndexingSupported() const;
+    const VkPhysicalDeviceDescriptorIndexingPropertiesEXT &descriptorIndexingProperties() const;
+    bool isBufferDeviceAddressSupported() const;
+    bool isMemoryBudgetSupported() const;
+    PFN_vkGetBufferDeviceAddressKHR getBufferDeviceAddress() const;
+    VkDeviceAddress bufferDeviceAddress(VkBuffer buffer) const;
+
+  private:
+    SeDeviceContext(const SeDeviceContext &) = delete;
+    SeDeviceContext &operator=(const SeDeviceContext &) = delete;
+
+    void createLogicalDevice(VkSurfaceKHR surface);
+    void destroyLogicalDevice();
+    void createPipelineCache();
+    void destroyPipelineCache();
+
+    const std::vector<const char *> m_device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    const std::vector<const char *> m_present_timing_extensions = {VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME};
+    std::vector<const char *> m_enabled_device_extensions;
+
+    SeVulkanManager *m_vulkan_manager = nullptr;
+    VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    uint32_t m_device_api_version = VK_API_VERSION_1_0;
+    VkDevice m_device = VK_NULL_HANDLE;
+    SeQueueFamilyIndices m_queue_family_indices;
+    std::map<uint32_t, VkQueue> m_queues;
+    VkQueue m_graphics_queue = VK_NULL_HANDLE;
+    VkQueue m_compute_queue = VK_NULL_HANDLE;
+    VkQueue m_transfer_queue = VK_NULL_HANDLE;
+    VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
+    SeMemoryAllocator m_memory_allocator;
+    SeResidencyManager m_residency_manager;
+    SeUploadRing m_upload_ring;
+    SeDescriptorLayoutCache m_descriptor_layout_cache;
+
+    bool m_present_timing_supported = false;
+    PFN_vkWaitForPresentKHR m_vkWaitForPresentKHR = nullptr;
+    bool m_dynamic_rendering_supported = false;
+    PFN_vkCmdBeginRenderingKHR m_vkCmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR m_vkCmdEndRendering = nullptr;
+    PFN_vkCmdPipelineBarrier2KHR m_vkCmdPipelineBarrier2 = nullptr;
+    bool m_descriptor_indexing_supported = false;
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT m_descriptor_indexing_properties{};
+    bool m_buffer_device_address_supported = false;
+    PFN_vkGetBufferDeviceAddressKHR m_vkGetBufferDeviceAddress = nullptr;
+    bool m_memory_budget_supported = false;
+
+    std::map<const void *, DeviceLostHandler> m_users;
+    bool m_device_lost = false;
+    // Users that started a frame in the current device frame
+    std::set<const void *> m_frame_users;
+    uint64_t m_frame_number = 0;
+};
+
+#endif
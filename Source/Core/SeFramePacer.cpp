@@ -0,0 +1,230 @@
+#include "SeFramePacer.h"
+#include <QDebug>
+#include <algorithm>
+
+#pragma region Init and cleanup
+SeFramePacer::SeFramePacer() {
+}
+
+SeFramePacer::~SeFramePacer() {
+    stop();
+}
+
+void SeFramePacer::start(VkDevice device, VkSwapchainKHR swap_chain, PFN_vkWaitForPresentKHR wait_for_present, std::mutex *swap_chain_mutex) {
+    assert(device != VK_NULL_HANDLE && swap_chain != VK_NULL_HANDLE);
+    assert(wait_for_present != nullptr && swap_chain_mutex != nullptr);
+    stop();
+
+    m_device = device;
+    m_swap_chain = swap_chain;
+    m_wait_for_present = wait_for_present;
+    m_swap_chain_mutex = swap_chain_mutex;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = true;
+        // Timings of an old swap chain say nothing about the new one
+        m_completed_frames.clear();
+        m_work_budget = Clock::duration::zero();
+    }
+    m_wait_thread = std::thread(&SeFramePacer::waitThread, this);
+    qDebug() << "Frame pacer started";
+}
+
+void SeFramePacer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_pending_frames.clear();
+    }
+    m_condition.notify_all();
+    if (m_wait_thread.joinable()) {
+        m_wait_thread.join();
+    }
+    m_swap_chain = VK_NULL_HANDLE;
+    qDebug() << "Frame pacer stopped";
+}
+
+bool SeFramePacer::isRunning() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Frame timing
+void SeFramePacer::setAdaptivePacing(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_adaptive_pacing = enabled;
+    m_work_budget = Clock::duration::zero();
+}
+
+bool SeFramePacer::isAdaptivePacing() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_adaptive_pacing;
+}
+
+void SeFramePacer::waitForFrameStart() {
+    Clock::time_point target;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_adaptive_pacing || m_completed_frames.empty() || m_work_budget == Clock::duration::zero()) {
+            return;
+        }
+        Clock::duration interval = presentInterval();
+        if (interval == Clock::duration::zero()) {
+            return;
+        }
+
+        // Start exactly one work budget ahead of the next presentation slot
+        // that can still be reached
+        Clock::time_point last_done = m_completed_frames.back().present_done_time;
+        Clock::time_point now = Clock::now();
+        auto slots = (now + m_work_budget - last_done) / interval + 1;
+        target = last_done + slots * interval - m_work_budget;
+    }
+    std::this_thread::sleep_until(target);
+}
+
+uint64_t SeFramePacer::beginFrame() {
+    m_current_acquire_time = Clock::now();
+    return m_next_present_id++;
+}
+
+void SeFramePacer::framePresented(uint64_t present_id) {
+    FrameTiming timing;
+    timing.present_id = present_id;
+    timing.acquire_time = m_current_acquire_time;
+    timing.present_submit_time = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_pending_frames.push_back(timing);
+    }
+    m_condition.notify_one();
+}
+
+void SeFramePacer::waitThread() {
+    while (true) {
+        FrameTiming timing;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return !m_running || !m_pending_frames.empty(); });
+            if (!m_running) {
+                return;
+            }
+            timing = m_pending_frames.front();
+            m_pending_frames.pop_front();
+        }
+
+        // The swap chain is externally synchronized with acquire and present,
+        // so wait in short slices and let the render thread in between. The
+        // render thread only ever holds the lock for a slice as well
+        VkResult result = VK_TIMEOUT;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> swap_chain_lock(*m_swap_chain_mutex);
+                result = m_wait_for_present(m_device, m_swap_chain, timing.present_id, WAIT_SLICE_NS);
+            }
+            if (result != VK_TIMEOUT) {
+                // Stamp before anything else can delay the measurement
+                timing.present_done_time = Clock::now();
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_running) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+
+        if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            recordTiming(timing);
+        } else {
+            qDebug() << "Failed to wait for present " << timing.present_id << ": " << result;
+        }
+    }
+}
+
+void SeFramePacer::recordTiming(const FrameTiming &timing) {
+    m_completed_frames.push_back(timing);
+    while (m_completed_frames.size() > MAX_TIMING_HISTORY) {
+        m_completed_frames.pop_front();
+    }
+
+    Clock::duration interval = presentInterval();
+    if (!m_adaptive_pacing || interval == Clock::duration::zero()) {
+        return;
+    }
+    if (m_work_budget == Clock::duration::zero()) {
+        m_work_budget = interval;
+        return;
+    }
+
+    // Additive decrease while frames make their slot, larger increase when a
+    // frame slipped to a later one
+    Clock::duration latency = timing.present_done_time - timing.acquire_time;
+    Clock::duration cpu_time = timing.present_submit_time - timing.acquire_time;
+    if (latency > m_work_budget + interval / 2) {
+        m_missed_frame_count++;
+        m_work_budget = std::min(interval, m_work_budget + interval / 10);
+    } else {
+        m_work_budget = std::max(cpu_time + interval / 20, m_work_budget - interval / 100);
+    }
+}
+
+SeFramePacer::Clock::duration SeFramePacer::presentInterval() const {
+    if (m_completed_frames.size() < 2) {
+        return Clock::duration::zero();
+    }
+    Clock::duration total = m_completed_frames.back().present_done_time - m_completed_frames.front().present_done_time;
+    uint64_t frames = m_completed_frames.back().present_id - m_completed_frames.front().present_id;
+    return frames > 0 ? total / frames : Clock::duration::zero();
+}
+
+#pragma endregion Frame timing
+
+#pragma region Statistics
+double SeFramePacer::averageLatencyMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_completed_frames.empty()) {
+        return 0.0;
+    }
+    Clock::duration total = Clock::duration::zero();
+    for (const auto &timing : m_completed_frames) {
+        total += timing.present_done_time - timing.acquire_time;
+    }
+    return std::chrono::duration<double, std::milli>(total).count() / m_completed_frames.size();
+}
+
+double SeFramePacer::averagePresentIntervalMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::chrono::duration<double, std::milli>(presentInterval()).count();
+}
+
+double SeFramePacer::workBudgetMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::chrono::duration<double, std::milli>(m_work_budget).count();
+}
+
+size_t SeFramePacer::missedFrameCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_missed_frame_count;
+}
+
+void SeFramePacer::logStatistics() const {
+    qDebug() << "Present timing:"
+             << " latency" << averageLatencyMs() << "ms,"
+             << " interval" << averagePresentIntervalMs() << "ms,"
+             << " work budget" << workBudgetMs() << "ms,"
+             << " missed" << missedFrameCount();
+}
+
+#pragma endregion Statistics
@@ -0,0 +1,79 @@
+#ifndef SE_FRAME_PACER_H
+#define SE_FRAME_PACER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vulkan/vulkan.h>
+
+// Tags presented frames with VK_KHR_present_id and waits for their completion
+// with VK_KHR_present_wait on a background thread, recording the time from
+// image acquisition to the moment the image reached the display. The measured
+// timings drive an optional adaptive pacing mode that delays the start of CPU
+// work so a frame finishes just before the presentation slot it targets.
+class SeFramePacer {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameTiming {
+        uint64_t present_id = 0;
+        Clock::time_point acquire_time;
+        Clock::time_point present_submit_time;
+        Clock::time_point present_done_time;
+    };
+
+    SeFramePacer();
+    ~SeFramePacer();
+
+    void start(VkDevice device, VkSwapchainKHR swap_chain, PFN_vkWaitForPresentKHR wait_for_present, std::mutex *swap_chain_mutex);
+    void stop();
+    bool isRunning() const;
+
+    void setAdaptivePacing(bool enabled);
+    bool isAdaptivePacing() const;
+
+    void waitForFrameStart();
+    uint64_t beginFrame();
+    void framePresented(uint64_t present_id);
+
+    double averageLatencyMs() const;
+    double averagePresentIntervalMs() const;
+    double workBudgetMs() const;
+    size_t missedFrameCount() const;
+    void logStatistics() const;
+
+  private:
+    static constexpr size_t MAX_TIMING_HISTORY = 128;
+    static constexpr uint64_t WAIT_SLICE_NS = 1000000;
+
+    SeFramePacer(const SeFramePacer &) = delete;
+    SeFramePacer &operator=(const SeFramePacer &) = delete;
+
+    void waitThread();
+    void recordTiming(const FrameTiming &timing);
+    Clock::duration presentInterval() const;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkSwapchainKHR m_swap_chain = VK_NULL_HANDLE;
+    PFN_vkWaitForPresentKHR m_wait_for_present = nullptr;
+    std::mutex *m_swap_chain_mutex = nullptr;
+
+    std::thread m_wait_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<FrameTiming> m_pending_frames;
+    std::deque<FrameTiming> m_completed_frames;
+    bool m_running = false;
+
+    uint64_t m_next_present_id = 1;
+    Clock::time_point m_current_acquire_time;
+
+    bool m_adaptive_pacing = false;
+    Clock::duration m_work_budget = Clock::duration::zero();
+    size_t m_missed_frame_count = 0;
+};
+
+#endif
@@ -0,0 +1,596 @@
+#include "SeMemoryAllocator.h"
+#include <QDebug>
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+#pragma region Init and cleanup
+SeMemoryAllocator::SeMemoryAllocator() {
+}
+
+SeMemoryAllocator::~SeMemoryAllocator() {
+    cleanup();
+}
+
+void SeMemoryAllocator::init(VkPhysicalDevice physical_device, VkDevice device, bool buffer_device_address, bool memory_budget) {
+    assert(physical_device != VK_NULL_HANDLE && device != VK_NULL_HANDLE);
+    m_physical_device = physical_device;
+    m_device = device;
+    m_buffer_device_address = buffer_device_address;
+    m_memory_budget = memory_budget;
+    std::fill(std::begin(m_heap_allocated), std::end(m_heap_allocated), 0);
+    vkGetPhysicalDeviceMemoryProperties(m_physical_device, &m_memory_properties);
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(m_physical_device, &device_properties);
+    m_max_allocation_count = device_properties.limits.maxMemoryAllocationCount;
+}
+
+void SeMemoryAllocator::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &arena : m_arenas) {
+        if (arena.in_use) {
+            freeDeviceMemory(arena.allocation.memory, arena.allocation.memory_type, arena.allocation.size, arena.allocation.mapped != nullptr);
+        }
+    }
+    m_arenas.clear();
+    for (auto &block : m_blocks) {
+        if (block.memory == VK_NULL_HANDLE) {
+            continue;
+        }
+        if (block.allocation_count > 0) {
+            qDebug() << "Memory block freed with" << block.allocation_count << "live allocations!";
+        }
+        freeDeviceMemory(block.memory, block.memory_type, BLOCK_SIZE, block.mapped != nullptr);
+    }
+    m_blocks.clear();
+    if (m_dedicated_count > 0) {
+        qDebug() << m_dedicated_count << "dedicated allocations leaked!";
+    }
+    m_dedicated_count = 0;
+    m_dedicated_bytes = 0;
+    m_device = VK_NULL_HANDLE;
+    m_physical_device = VK_NULL_HANDLE;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Device memory
+uint32_t SeMemoryAllocator::findMemoryType(uint32_t type_bits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+        if ((type_bits & (1u << i)) && (m_memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+VkDeviceMemory SeMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memory_type, void **mapped) {
+    if (m_device_allocation_count >= m_max_allocation_count) {
+        qDebug() << "maxMemoryAllocationCount of" << m_max_allocation_count << "reached!";
+        return VK_NULL_HANDLE;
+    }
+
+    VkMemoryAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    // Blocks are shared by all kinds of resources, so any of them may back
+    // a buffer that is accessed through its address
+    VkMemoryAllocateFlagsInfo flags_info{};
+    flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+    if (m_buffer_device_address) {
+        alloc_info.pNext = &flags_info;
+    }
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult result;
+    result = vkAllocateMemory(m_device, &alloc_info, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to allocate" << size / 1024 << "KiB of device memory:" << result;
+        return VK_NULL_HANDLE;
+    }
+    m_device_allocation_count++;
+    m_heap_allocated[heapIndex(memory_type)] += size;
+
+    *mapped = nullptr;
+    if (m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+        assert(result == VK_SUCCESS);
+    }
+    return memory;
+}
+
+void SeMemoryAllocator::freeDeviceMemory(VkDeviceMemory memory, uint32_t memory_type, VkDeviceSize size, bool mapped) {
+    if (mapped) {
+        vkUnmapMemory(m_device, memory);
+    }
+    vkFreeMemory(m_device, memory, nullptr);
+    m_device_allocation_count--;
+    m_heap_allocated[heapIndex(memory_type)] -= size;
+}
+
+uint32_t SeMemoryAllocator::heapIndex(uint32_t memory_type) const {
+    assert(memory_type < m_memory_properties.memoryTypeCount);
+    return m_memory_properties.memoryTypes[memory_type].heapIndex;
+}
+
+std::vector<uint32_t> SeMemoryAllocator::candidateMemoryTypes(uint32_t type_bits, VkMemoryPropertyFlags properties) const {
+    std::vector<uint32_t> memory_types;
+    for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+        if ((type_bits & (1u << i)) && (m_memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            memory_types.push_back(i);
+        }
+    }
+    // Device local requests fall back to any other memory the resource can
+    // live in, slower to access but better than failing
+    if (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+        VkMemoryPropertyFlags fallback_properties = properties & ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+            if ((type_bits & (1u << i)) && (m_memory_properties.memoryTypes[i].propertyFlags & fallback_properties) == fallback_properties &&
+                std::find(memory_types.begin(), memory_types.end(), i) == memory_types.end()) {
+                memory_types.push_back(i);
+            }
+        }
+    }
+    return memory_types;
+}
+
+#pragma endregion Device memory
+
+#pragma region Budget
+std::vector<SeMemoryAllocator::HeapBudget> SeMemoryAllocator::heapBudgets() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return queryHeapBudgets();
+}
+
+std::vector<SeMemoryAllocator::HeapBudget> SeMemoryAllocator::queryHeapBudgets() const {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties{};
+    budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 memory_properties2{};
+    memory_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memory_properties2.pNext = &budget_properties;
+    if (m_memory_budget) {
+        vkGetPhysicalDeviceMemoryProperties2(m_physical_device, &memory_properties2);
+    }
+
+    std::vector<HeapBudget> budgets(m_memory_properties.memoryHeapCount);
+    for (uint32_t i = 0; i < m_memory_properties.memoryHeapCount; i++) {
+        HeapBudget &budget = budgets[i];
+        budget.size = m_memory_properties.memoryHeaps[i].size;
+        budget.device_local = (m_memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        budget.allocated = m_heap_allocated[i];
+        if (m_memory_budget) {
+            budget.budget = budget_properties.heapBudget[i];
+            budget.usage = budget_properties.heapUsage[i];
+        } else {
+            // Without the extension only this allocator's own use is known,
+            // and the rest of the system is assumed to leave a fifth free
+            budget.budget = budget.size / 5 * 4;
+            budget.usage = budget.allocated;
+        }
+    }
+    return budgets;
+}
+
+bool SeMemoryAllocator::fitsBudget(uint32_t memory_type, VkDeviceSize size) const {
+    const HeapBudget budget = queryHeapBudgets()[heapIndex(memory_type)];
+    return budget.usage + size <= budget.budget;
+}
+
+VkDeviceSize SeMemoryAllocator::trim() {
+    // Empty blocks are kept around for the next allocation of their type,
+    // under memory pressure they are worth more to the rest of the system
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VkDeviceSize freed_bytes = 0;
+    for (auto &block : m_blocks) {
+        if (block.memory != VK_NULL_HANDLE && block.allocation_count == 0) {
+            freeDeviceMemory(block.memory, block.memory_type, BLOCK_SIZE, block.mapped != nullptr);
+            block = Block{};
+            freed_bytes += BLOCK_SIZE;
+        }
+    }
+    return freed_bytes;
+}
+
+VkDeviceSize SeMemoryAllocator::releasableBytes(const std::vector<Allocation> &allocations) const {
+    // What goes back to the driver once all of them are freed and the empty
+    // blocks are trimmed, a block only counts when nothing else lives in it
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VkDeviceSize releasable_bytes = 0;
+    std::map<uint32_t, size_t> block_allocation_counts;
+    for (const auto &allocation : allocations) {
+        assert(allocation.isValid() && allocation.block != ARENA_BLOCK);
+        if (allocation.block == DEDICATED_BLOCK) {
+            releasable_bytes += allocation.size;
+        } else {
+            block_allocation_counts[allocation.block]++;
+        }
+    }
+    for (const auto &block_allocation_count : block_allocation_counts) {
+        if (m_blocks[block_allocation_count.first].allocation_count == block_allocation_count.second) {
+            releasable_bytes += BLOCK_SIZE;
+        }
+    }
+    return releasable_bytes;
+}
+
+#pragma endregion Budget
+
+#pragma region Buddy blocks
+SeMemoryAllocator::Allocation SeMemoryAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool optimal_tiling) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Allocation allocation;
+    std::vector<uint32_t> memory_types = candidateMemoryTypes(requirements.memoryTypeBits, properties);
+    if (memory_types.empty()) {
+        qDebug() << "No memory type with properties" << properties << "!";
+        return allocation;
+    }
+
+    // Memory that would push its heap over budget is only taken once no
+    // other type fits, since the driver would start paging it out
+    for (bool within_budget : {true, false}) {
+        for (auto memory_type : memory_types) {
+            allocation = allocateFromType(requirements, memory_type, optimal_tiling, within_budget);
+            if (allocation.isValid()) {
+                if (memory_type != memory_types.front()) {
+                    qDebug() << "Allocation of" << requirements.size / 1024 << "KiB fell back to memory type" << memory_type;
+                }
+                return allocation;
+            }
+        }
+    }
+    return allocation;
+}
+
+SeMemoryAllocator::Allocation SeMemoryAllocator::allocateFromType(const VkMemoryRequirements &requirements, uint32_t memory_type, bool optimal_tiling, bool within_budget) {
+    Allocation allocation;
+    // Buddy ranges are aligned to their size, so a range at least as large
+    // as the alignment is always aligned
+    VkDeviceSize size = std::max(requirements.size, requirements.alignment);
+    // Lazily allocated memory is only committed as tiles spill into it, a
+    // shared block would hand the driver ranges it has to back up front
+    bool lazily_allocated = (m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+    if (size > BLOCK_SIZE / 2 || lazily_allocated) {
+        if (within_budget && !fitsBudget(memory_type, requirements.size)) {
+            return allocation;
+        }
+        void *mapped = nullptr;
+        allocation.memory = allocateDeviceMemory(requirements.size, memory_type, &mapped);
+        if (allocation.memory == VK_NULL_HANDLE) {
+            return allocation;
+        }
+        allocation.size = requirements.size;
+        allocation.mapped = mapped;
+        allocation.memory_type = memory_type;
+        allocation.block = DEDICATED_BLOCK;
+        m_dedicated_count++;
+        m_dedicated_bytes += requirements.size;
+        return allocation;
+    }
+
+    uint32_t order = 0;
+    while ((VkDeviceSize(1) << (MIN_RANGE_SHIFT + order)) < size) {
+        order++;
+    }
+
+    uint32_t block_index = UINT32_MAX;
+    VkDeviceSize offset = 0;
+    for (uint32_t i = 0; i < m_blocks.size(); i++) {
+        const Block &block = m_blocks[i];
+        if (block.memory != VK_NULL_HANDLE && block.memory_type == memory_type && block.optimal_tiling == optimal_tiling && allocateFromBlock(i, order, offset)) {
+            block_index = i;
+            break;
+        }
+    }
+    if (block_index == UINT32_MAX) {
+        if (within_budget && !fitsBudget(memory_type, BLOCK_SIZE)) {
+            return allocation;
+        }
+        block_index = createBlock(memory_type, optimal_tiling);
+        if (block_index == UINT32_MAX || !allocateFromBlock(block_index, order, offset)) {
+            return allocation;
+        }
+    }
+
+    Block &block = m_blocks[block_index];
+    block.allocation_count++;
+    block.live_bytes += requirements.size;
+    block.used_bytes += VkDeviceSize(1) << (MIN_RANGE_SHIFT + order);
+
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = block.mapped != nullptr ? static_cast<char *>(block.mapped) + offset : nullptr;
+    allocation.memory_type = memory_type;
+    allocation.block = block_index;
+    allocation.order = order;
+    return allocation;
+}
+
+void SeMemoryAllocator::free(Allocation &allocation) {
+    if (!allocation.isValid()) {
+        return;
+    }
+    assert(allocation.block != ARENA_BLOCK);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (allocation.block == DEDICATED_BLOCK) {
+        freeDeviceMemory(allocation.memory, allocation.memory_type, allocation.size, allocation.mapped != nullptr);
+        m_dedicated_count--;
+        m_dedicated_bytes -= allocation.size;
+        allocation = Allocation{};
+        return;
+    }
+
+    uint32_t block_index = allocation.block;
+    Block &block = m_blocks[block_index];
+    assert(block.memory == allocation.memory);
+    block.allocation_count--;
+    block.live_bytes -= allocation.size;
+    block.used_bytes -= VkDeviceSize(1) << (MIN_RANGE_SHIFT + allocation.order);
+
+    // Merge with the buddy for as long as it is free as well
+    VkDeviceSize offset = allocation.offset;
+    uint32_t order = allocation.order;
+    while (order < ORDER_COUNT - 1) {
+        VkDeviceSize buddy = offset ^ (VkDeviceSize(1) << (MIN_RANGE_SHIFT + order));
+        auto itr = block.free_ranges[order].find(buddy);
+        if (itr == block.free_ranges[order].end()) {
+            break;
+        }
+        block.free_ranges[order].erase(itr);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    block.free_ranges[order].insert(offset);
+    allocation = Allocation{};
+
+    // Keep one empty block per memory type around so a resource that is
+    // recreated every few frames does not allocate device memory each time
+    if (block.allocation_count == 0 && !isLastBlock(block_index)) {
+        freeDeviceMemory(block.memory, block.memory_type, BLOCK_SIZE, block.mapped != nullptr);
+        block = Block{};
+    }
+}
+
+uint32_t SeMemoryAllocator::createBlock(uint32_t memory_type, bool optimal_tiling) {
+    void *mapped = nullptr;
+    VkDeviceMemory memory = allocateDeviceMemory(BLOCK_SIZE, memory_type, &mapped);
+    if (memory == VK_NULL_HANDLE) {
+        return UINT32_MAX;
+    }
+
+    uint32_t block_index = 0;
+    while (block_index < m_blocks.size() && m_blocks[block_index].memory != VK_NULL_HANDLE) {
+        block_index++;
+    }
+    if (block_index == m_blocks.size()) {
+        m_blocks.emplace_back();
+    }
+
+    Block &block = m_blocks[block_index];
+    block.memory = memory;
+    block.mapped = mapped;
+    block.memory_type = memory_type;
+    block.optimal_tiling = optimal_tiling;
+    block.free_ranges.assign(ORDER_COUNT, {});
+    block.free_ranges[ORDER_COUNT - 1].insert(0);
+    qDebug() << "Memory block" << block_index << "created for memory type" << memory_type << (optimal_tiling ? "(images)" : "(buffers)");
+    return block_index;
+}
+
+bool SeMemoryAllocator::allocateFromBlock(uint32_t block_index, uint32_t order, VkDeviceSize &offset) {
+    Block &block = m_blocks[block_index];
+    uint32_t found_order = order;
+    while (found_order < ORDER_COUNT && block.free_ranges[found_order].empty()) {
+        found_order++;
+    }
+    if (found_order == ORDER_COUNT) {
+        return false;
+    }
+
+    // Lowest offset first keeps the tail of the block free for large ranges
+    offset = *block.free_ranges[found_order].begin();
+    block.free_ranges[found_order].erase(block.free_ranges[found_order].begin());
+    while (found_order > order) {
+        found_order--;
+        block.free_ranges[found_order].insert(offset + (VkDeviceSize(1) << (MIN_RANGE_SHIFT + found_order)));
+    }
+    return true;
+}
+
+bool SeMemoryAllocator::isLastBlock(uint32_t block_index) const {
+    const Block &block = m_blocks[block_index];
+    for (uint32_t i = 0; i < m_blocks.size(); i++) {
+        if (i != block_index && m_blocks[i].memory != VK_NULL_HANDLE && m_blocks[i].memory_type == block.memory_type && m_blocks[i].optimal_tiling == block.optimal_tiling) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma endregion Buddy blocks
+
+#pragma region Resources
+VkResult SeMemoryAllocator::createBuffer(const VkBufferCreateInfo &buffer_info, VkMemoryPropertyFlags properties, VkBuffer &buffer, Allocation &allocation) {
+    VkResult result;
+    result = vkCreateBuffer(m_device, &buffer_info, nullptr, &buffer);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(m_device, buffer, &requirements);
+    allocation = allocate(requirements, properties, false);
+    if (!allocation.isValid()) {
+        vkDestroyBuffer(m_device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    return vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+}
+
+void SeMemoryAllocator::destroyBuffer(VkBuffer &buffer, Allocation &allocation) {
+    if (buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+    }
+    free(allocation);
+}
+
+VkResult SeMemoryAllocator::createImage(const VkImageCreateInfo &image_info, VkMemoryPropertyFlags properties, VkImage &image, Allocation &allocation) {
+    VkResult result;
+    result = vkCreateImage(m_device, &image_info, nullptr, &image);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_device, image, &requirements);
+    allocation = allocate(requirements, properties, image_info.tiling == VK_IMAGE_TILING_OPTIMAL);
+    if (!allocation.isValid()) {
+        vkDestroyImage(m_device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    return vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+}
+
+void SeMemoryAllocator::destroyImage(VkImage &image, Allocation &allocation) {
+    if (image != VK_NULL_HANDLE) {
+        vkDestroyImage(m_device, image, nullptr);
+        image = VK_NULL_HANDLE;
+    }
+    free(allocation);
+}
+
+#pragma endregion Resources
+
+#pragma region Linear arenas
+SeMemoryAllocator::ArenaHandle SeMemoryAllocator::createArena(VkDeviceSize size, uint32_t memory_type_bits, VkMemoryPropertyFlags properties) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t memory_type = findMemoryType(memory_type_bits, properties);
+    if (memory_type == UINT32_MAX) {
+        qDebug() << "No memory type with properties" << properties << "for arena!";
+        return INVALID_ARENA;
+    }
+
+    void *mapped = nullptr;
+    VkDeviceMemory memory = allocateDeviceMemory(size, memory_type, &mapped);
+    if (memory == VK_NULL_HANDLE) {
+        return INVALID_ARENA;
+    }
+
+    ArenaHandle handle = 0;
+    while (handle < m_arenas.size() && m_arenas[handle].in_use) {
+        handle++;
+    }
+    if (handle == m_arenas.size()) {
+        m_arenas.emplace_back();
+    }
+    Arena &arena = m_arenas[handle];
+    arena.allocation.memory = memory;
+    arena.allocation.size = size;
+    arena.allocation.mapped = mapped;
+    arena.allocation.memory_type = memory_type;
+    arena.allocation.block = ARENA_BLOCK;
+    arena.head = 0;
+    arena.in_use = true;
+    return handle;
+}
+
+SeMemoryAllocator::Allocation SeMemoryAllocator::allocateFromArena(ArenaHandle handle, VkDeviceSize size, VkDeviceSize alignment) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(handle < m_arenas.size() && m_arenas[handle].in_use && alignment > 0);
+    Arena &arena = m_arenas[handle];
+
+    Allocation allocation;
+    VkDeviceSize offset = (arena.head + alignment - 1) / alignment * alignment;
+    if (offset + size > arena.allocation.size) {
+        // Full until the next reset, the caller decides how to fall back
+        return allocation;
+    }
+    arena.head = offset + size;
+
+    allocation = arena.allocation;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.mapped = arena.allocation.mapped != nullptr ? static_cast<char *>(arena.allocation.mapped) + offset : nullptr;
+    return allocation;
+}
+
+void SeMemoryAllocator::resetArena(ArenaHandle handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(handle < m_arenas.size() && m_arenas[handle].in_use);
+    m_arenas[handle].head = 0;
+}
+
+void SeMemoryAllocator::destroyArena(ArenaHandle handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(handle < m_arenas.size() && m_arenas[handle].in_use);
+    Arena &arena = m_arenas[handle];
+    freeDeviceMemory(arena.allocation.memory, arena.allocation.memory_type, arena.allocation.size, arena.allocation.mapped != nullptr);
+    arena = Arena{};
+}
+
+#pragma endregion Linear arenas
+
+#pragma region Statistics
+SeMemoryAllocator::Stats SeMemoryAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.device_allocation_count = m_device_allocation_count;
+    stats.dedicated_count = m_dedicated_count;
+    stats.live_allocation_count = m_dedicated_count;
+    stats.reserved_bytes = m_dedicated_bytes;
+    stats.live_bytes = m_dedicated_bytes;
+    // Free space that is not part of its block's largest range cannot serve
+    // the largest requests
+    VkDeviceSize largest_ranges_bytes = 0;
+    for (const auto &block : m_blocks) {
+        if (block.memory == VK_NULL_HANDLE) {
+            continue;
+        }
+        stats.block_count++;
+        stats.live_allocation_count += block.allocation_count;
+        stats.reserved_bytes += BLOCK_SIZE;
+        stats.live_bytes += block.live_bytes;
+        stats.free_bytes += BLOCK_SIZE - block.used_bytes;
+        for (uint32_t order = ORDER_COUNT; order-- > 0;) {
+            if (!block.free_ranges[order].empty()) {
+                VkDeviceSize range_size = VkDeviceSize(1) << (MIN_RANGE_SHIFT + order);
+                stats.largest_free_range = std::max(stats.largest_free_range, range_size);
+                largest_ranges_bytes += range_size;
+                break;
+            }
+        }
+    }
+    for (const auto &arena : m_arenas) {
+        if (arena.in_use) {
+            stats.arena_count++;
+            stats.reserved_bytes += arena.allocation.size;
+            stats.arena_used_bytes += arena.head;
+        }
+    }
+    if (stats.free_bytes > 0) {
+        stats.fragmentation = 1.0 - static_cast<double>(largest_ranges_bytes) / static_cast<double>(stats.free_bytes);
+    }
+    return stats;
+}
+
+void SeMemoryAllocator::printStats() const {
+    Stats current = stats();
+    qDebug() << "Device memory:" << current.device_allocation_count << "allocations of" << m_max_allocation_count << "," << current.reserved_bytes / 1024 << "KiB reserved";
+    qDebug() << " " << current.live_allocation_count << "live allocations," << current.live_bytes / 1024 << "KiB live," << current.dedicated_count << "dedicated";
+    qDebug() << " " << current.block_count << "blocks," << current.free_bytes / 1024 << "KiB free, largest free range" << current.largest_free_range / 1024 << "KiB, fragmentation" << current.fragmentation;
+    qDebug() << " " << current.arena_count << "arenas," << current.arena_used_bytes / 1024 << "KiB used this frame";
+}
+
+#pragma endregion Statistics
@@ -0,0 +1,156 @@
+#ifndef SE_MEMORY_ALLOCATOR_H
+#define SE_MEMORY_ALLOCATOR_H
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Sub-allocates device memory so that buffers and images do not each cost a
+// vkAllocateMemory call and run into maxMemoryAllocationCount. Long-lived
+// resources come from 64 MiB blocks per memory type that are split with a
+// buddy scheme: every range is a power of two aligned to its own size, and
+// freed ranges merge with their buddy again. Linear and optimally tiled
+// resources never share a block, which keeps them bufferImageGranularity
+// apart without padding. Requests larger than half a block get a dedicated
+// allocation. Per-frame data uses linear arenas instead, which bump a
+// pointer through one allocation and are reset wholesale. Host visible
+// memory stays mapped for its whole life. With buffer device address
+// enabled every allocation can back buffers whose address shaders read.
+// New device memory is only taken from a heap while it stays within the
+// budget VK_EXT_memory_budget reports; otherwise device local requests go
+// to another memory type the resource supports before exceeding it.
+// Lazily allocated memory always gets a dedicated allocation.
+class SeMemoryAllocator {
+  public:
+    using ArenaHandle = uint32_t;
+    static constexpr ArenaHandle INVALID_ARENA = UINT32_MAX;
+
+    struct Allocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Points at offset, nullptr unless the memory is host visible
+        void *mapped = nullptr;
+        uint32_t memory_type = 0;
+
+        uint32_t block = UINT32_MAX;
+        uint32_t order = 0;
+
+        bool isValid() const {
+            return memory != VK_NULL_HANDLE;
+        }
+    };
+
+    struct HeapBudget {
+        VkDeviceSize size = 0;
+        // What the process may use and uses, including other allocators.
+        // Estimated from this allocator's own use without the extension
+        VkDeviceSize budget = 0;
+        VkDeviceSize usage = 0;
+        VkDeviceSize allocated = 0;
+        bool device_local = false;
+    };
+
+    struct Stats {
+        size_t device_allocation_count = 0;
+        size_t block_count = 0;
+        size_t dedicated_count = 0;
+        size_t live_allocation_count = 0;
+        VkDeviceSize reserved_bytes = 0;
+        VkDeviceSize live_bytes = 0;
+        // Free space inside the blocks and the largest range among it.
+        // Fragmentation is the share of free space outside each block's
+        // largest free range
+        VkDeviceSize free_bytes = 0;
+        VkDeviceSize largest_free_range = 0;
+        double fragmentation = 0.0;
+        size_t arena_count = 0;
+        VkDeviceSize arena_used_bytes = 0;
+    };
+
+    SeMemoryAllocator();
+    ~SeMemoryAllocator();
+
+    void init(VkPhysicalDevice physical_device, VkDevice device, bool buffer_device_address = false, bool memory_budget = false);
+    void cleanup();
+
+    uint32_t findMemoryType(uint32_t type_bits, VkMemoryPropertyFlags properties) const;
+    uint32_t heapIndex(uint32_t memory_type) const;
+    std::vector<HeapBudget> heapBudgets() const;
+    VkDeviceSize trim();
+    VkDeviceSize releasableBytes(const std::vector<Allocation> &allocations) const;
+    Allocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool optimal_tiling);
+    void free(Allocation &allocation);
+
+    VkResult createBuffer(const VkBufferCreateInfo &buffer_info, VkMemoryPropertyFlags properties, VkBuffer &buffer, Allocation &allocation);
+    void destroyBuffer(VkBuffer &buffer, Allocation &allocation);
+    VkResult createImage(const VkImageCreateInfo &image_info, VkMemoryPropertyFlags properties, VkImage &image, Allocation &allocation);
+    void destroyImage(VkImage &image, Allocation &allocation);
+
+    ArenaHandle createArena(VkDeviceSize size, uint32_t memory_type_bits, VkMemoryPropertyFlags properties);
+    Allocation allocateFromArena(ArenaHandle arena, VkDeviceSize size, VkDeviceSize alignment);
+    void resetArena(ArenaHandle arena);
+    void destroyArena(ArenaHandle arena);
+
+    Stats stats() const;
+    void printStats() const;
+
+  private:
+    static constexpr uint32_t MIN_RANGE_SHIFT = 8;
+    static constexpr uint32_t BLOCK_SHIFT = 26;
+    static constexpr uint32_t ORDER_COUNT = BLOCK_SHIFT - MIN_RANGE_SHIFT + 1;
+    static constexpr VkDeviceSize BLOCK_SIZE = VkDeviceSize(1) << BLOCK_SHIFT;
+    // Markers in Allocation::block for ranges outside the buddy blocks
+    static constexpr uint32_t DEDICATED_BLOCK = UINT32_MAX;
+    static constexpr uint32_t ARENA_BLOCK = UINT32_MAX - 1;
+
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mapped = nullptr;
+        uint32_t memory_type = 0;
+        bool optimal_tiling = false;
+        // Free range offsets per order, order k covers MIN_RANGE << k bytes
+        std::vector<std::set<VkDeviceSize>> free_ranges;
+        size_t allocation_count = 0;
+        VkDeviceSize live_bytes = 0;
+        VkDeviceSize used_bytes = 0;
+    };
+
+    struct Arena {
+        Allocation allocation;
+        VkDeviceSize head = 0;
+        bool in_use = false;
+    };
+
+    SeMemoryAllocator(const SeMemoryAllocator &) = delete;
+    SeMemoryAllocator &operator=(const SeMemoryAllocator &) = delete;
+
+    VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memory_type, void **mapped);
+    void freeDeviceMemory(VkDeviceMemory memory, uint32_t memory_type, VkDeviceSize size, bool mapped);
+    std::vector<uint32_t> candidateMemoryTypes(uint32_t type_bits, VkMemoryPropertyFlags properties) const;
+    std::vector<HeapBudget> queryHeapBudgets() const;
+    bool fitsBudget(uint32_t memory_type, VkDeviceSize size) const;
+    Allocation allocateFromType(const VkMemoryRequirements &requirements, uint32_t memory_type, bool optimal_tiling, bool within_budget);
+    uint32_t createBlock(uint32_t memory_type, bool optimal_tiling);
+    bool allocateFromBlock(uint32_t block_index, uint32_t order, VkDeviceSize &offset);
+    bool isLastBlock(uint32_t block_index) const;
+
+    VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties m_memory_properties{};
+    uint32_t m_max_allocation_count = 0;
+    bool m_buffer_device_address = false;
+    bool m_memory_budget = false;
+
+    mutable std::mutex m_mutex;
+    std::vector<Block> m_blocks;
+    std::vector<Arena> m_arenas;
+    size_t m_device_allocation_count = 0;
+    size_t m_dedicated_count = 0;
+    VkDeviceSize m_dedicated_bytes = 0;
+    VkDeviceSize m_heap_allocated[VK_MAX_MEMORY_HEAPS] = {};
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "SeParallelRecorder.h"
+#include <QDebug>
+#include <algorithm>
+
+#pragma region Init and cleanup
+SeParallelRecorder::SeParallelRecorder() {
+}
+
+SeParallelRecorder::~SeParallelRecorder() {
+    cleanup();
+}
+
+void SeParallelRecorder::init(VkDevice device, uint32_t queue_family_index, uint32_t frame_count, uint32_t thread_count) {
+    assert(device != VK_NULL_HANDLE && frame_count > 0);
+    cleanup();
+
+    if (thread_count == 0) {
+        // Leave one core to the render thread that stitches the results
+        thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    m_device = device;
+    m_frame_index = 0;
+    m_contexts.resize(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++) {
+        m_contexts[i].frame_command_pools.resize(frame_count);
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_info.queueFamilyIndex = queue_family_index;
+
+            VkResult result;
+            result = vkCreateCommandPool(m_device, &pool_info, nullptr, &m_contexts[i].frame_command_pools[frame]);
+            if (result != VK_SUCCESS) {
+                qDebug() << "Failed to create recording command pool" << i << "for frame" << frame << "!";
+            }
+            assert(result == VK_SUCCESS);
+        }
+        m_contexts[i].frame_command_buffers.resize(frame_count);
+        m_contexts[i].frame_used_counts.resize(frame_count, 0);
+    }
+
+    m_stopping = false;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        m_threads.emplace_back(&SeParallelRecorder::workerThread, this, i);
+    }
+    qDebug() << "Parallel recorder started with" << thread_count << "threads";
+}
+
+void SeParallelRecorder::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_condition.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+
+    // Destroying a pool frees every command buffer allocated from it
+    for (auto &context : m_contexts) {
+        for (auto command_pool : context.frame_command_pools) {
+            vkDestroyCommandPool(m_device, command_pool, nullptr);
+        }
+    }
+    m_contexts.clear();
+    m_device = VK_NULL_HANDLE;
+    qDebug() << "Parallel recorder stopped";
+}
+
+uint32_t SeParallelRecorder::threadCount() const {
+    return static_cast<uint32_t>(m_threads.size());
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Recording
+void SeParallelRecorder::beginFrame(uint32_t frame_index) {
+    // The caller has waited for this frame's fence and no recording is in
+    // progress, so the frame's pools can be reset from this thread
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frame_index = frame_index;
+    for (auto &context : m_contexts) {
+        vkResetCommandPool(m_device, context.frame_command_pools[frame_index], 0);
+        context.frame_used_counts[frame_index] = 0;
+    }
+}
+
+std::vector<VkCommandBuffer> SeParallelRecorder::record(const VkCommandBufferInheritanceInfo &inheritance, VkCommandBufferUsageFlags usage_flags, const std::vector<RecordFunction> &tasks) {
+    return record(std::vector<VkCommandBufferInheritanceInfo>(tasks.size(), inheritance), usage_flags, tasks);
+}
+
+std::vector<VkCommandBuffer> SeParallelRecorder::record(const std::vector<VkCommandBufferInheritanceInfo> &inheritances, VkCommandBufferUsageFlags usage_flags, const std::vector<RecordFunction> &tasks) {
+    // One inheritance per task, passes may render to different attachments
+    assert(!m_threads.empty() && inheritances.size() == tasks.size());
+    if (tasks.empty()) {
+        return {};
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasks = &tasks;
+    m_inheritances = &inheritances;
+    m_usage_flags = usage_flags;
+    m_results.assign(tasks.size(), VK_NULL_HANDLE);
+    m_next_task = 0;
+    m_remaining_tasks = tasks.size();
+    m_generation++;
+    m_work_condition.notify_all();
+
+    m_done_condition.wait(lock, [this] { return m_remaining_tasks == 0; });
+    m_tasks = nullptr;
+    m_inheritances = nullptr;
+    return m_results;
+}
+
+VkCommandBuffer SeParallelRecorder::acquireCommandBuffer(ThreadContext &context, uint32_t frame_index) {
+    auto &command_buffers = context.frame_command_buffers[frame_index];
+    size_t &used_count = context.frame_used_counts[frame_index];
+    if (used_count == command_buffers.size()) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = context.frame_command_pools[frame_index];
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_info.commandBufferCount = 1;
+
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkResult result;
+        result = vkAllocateCommandBuffers(m_device, &alloc_info, &command_buffer);
+        assert(result == VK_SUCCESS);
+        command_buffers.push_back(command_buffer);
+    }
+    return command_buffers[used_count++];
+}
+
+void SeParallelRecorder::workerThread(uint32_t thread_index) {
+    ThreadContext &context = m_contexts[thread_index];
+    uint64_t seen_generation = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_work_condition.wait(lock, [&] { return m_stopping || m_generation != seen_generation; });
+        if (m_stopping) {
+            return;
+        }
+        seen_generation = m_generation;
+
+        while (m_tasks != nullptr && m_next_task < m_tasks->size()) {
+            size_t task_index = m_next_task++;
+            uint32_t frame_index = m_frame_index;
+            const RecordFunction &task = (*m_tasks)[task_index];
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = m_usage_flags;
+            begin_info.pInheritanceInfo = &(*m_inheritances)[task_index];
+            lock.unlock();
+
+            VkCommandBuffer command_buffer = acquireCommandBuffer(context, frame_index);
+            VkResult result;
+            result = vkBeginCommandBuffer(command_buffer, &begin_info);
+            assert(result == VK_SUCCESS);
+            task(command_buffer);
+            result = vkEndCommandBuffer(command_buffer);
+            assert(result == VK_SUCCESS);
+
+            lock.lock();
+            m_results[task_index] = command_buffer;
+            if (--m_remaining_tasks == 0) {
+                m_done_condition.notify_one();
+            }
+        }
+    }
+}
+
+#pragma endregion Recording
@@ -0,0 +1,66 @@
+#ifndef SE_PARALLEL_RECORDER_H
+#define SE_PARALLEL_RECORDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Records independent passes or preview panes into secondary command buffers
+// on a set of worker threads. Every worker owns one transient command pool per
+// frame in flight, so no pool is ever touched by two threads, and a frame's
+// pools are reset wholesale in beginFrame once its fence has signaled. The
+// caller executes the returned buffers, in task order, from its primary
+// command buffer with vkCmdExecuteCommands.
+class SeParallelRecorder {
+  public:
+    using RecordFunction = std::function<void(VkCommandBuffer command_buffer)>;
+
+    SeParallelRecorder();
+    ~SeParallelRecorder();
+
+    void init(VkDevice device, uint32_t queue_family_index, uint32_t frame_count, uint32_t thread_count = 0);
+    void cleanup();
+    uint32_t threadCount() const;
+
+    void beginFrame(uint32_t frame_index);
+    std::vector<VkCommandBuffer> record(const VkCommandBufferInheritanceInfo &inheritance, VkCommandBufferUsageFlags usage_flags, const std::vector<RecordFunction> &tasks);
+    std::vector<VkCommandBuffer> record(const std::vector<VkCommandBufferInheritanceInfo> &inheritances, VkCommandBufferUsageFlags usage_flags, const std::vector<RecordFunction> &tasks);
+
+  private:
+    struct ThreadContext {
+        std::vector<VkCommandPool> frame_command_pools;
+        std::vector<std::vector<VkCommandBuffer>> frame_command_buffers;
+        std::vector<size_t> frame_used_counts;
+    };
+
+    SeParallelRecorder(const SeParallelRecorder &) = delete;
+    SeParallelRecorder &operator=(const SeParallelRecorder &) = delete;
+
+    void workerThread(uint32_t thread_index);
+    VkCommandBuffer acquireCommandBuffer(ThreadContext &context, uint32_t frame_index);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    uint32_t m_frame_index = 0;
+
+    std::vector<ThreadContext> m_contexts;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_condition;
+    std::condition_variable m_done_condition;
+    bool m_stopping = false;
+    uint64_t m_generation = 0;
+
+    const std::vector<RecordFunction> *m_tasks = nullptr;
+    const std::vector<VkCommandBufferInheritanceInfo> *m_inheritances = nullptr;
+    VkCommandBufferUsageFlags m_usage_flags = 0;
+    std::vector<VkCommandBuffer> m_results;
+    size_t m_next_task = 0;
+    size_t m_remaining_tasks = 0;
+};
+
+#endif
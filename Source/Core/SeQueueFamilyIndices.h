@@ -6,6 +6,10 @@
 struct SeQueueFamilyIndices {
     std::optional<uint32_t> graphic_family;
     std::optional<uint32_t> present_family;
+    // Dedicated families without graphics, so compute passes and uploads can
+    // overlap graphics work. Empty when the device only has combined families
+    std::optional<uint32_t> compute_family;
+    std::optional<uint32_t> transfer_family;
 
     bool isComplete() {
         return graphic_family.has_value() && present_family.has_value();
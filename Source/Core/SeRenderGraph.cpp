@@ -0,0 +1,628 @@
+#include "SeRenderGraph.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+#pragma region Init and cleanup
+SeRenderGraph::SeRenderGraph() {
+}
+
+SeRenderGraph::~SeRenderGraph() {
+    cleanup();
+}
+
+void SeRenderGraph::init(VkDevice device, SeMemoryAllocator *memory_allocator, SeDescriptorLayoutCache *layout_cache, SeDescriptorAllocator *descriptor_allocator, PFN_vkCmdBeginRenderingKHR begin_rendering,
+                         PFN_vkCmdEndRenderingKHR end_rendering, SeResourceStateTracker *state_tracker, SeDeletionQueue *deletion_queue) {
+    assert(device != VK_NULL_HANDLE && memory_allocator != nullptr && layout_cache != nullptr && descriptor_allocator != nullptr && state_tracker != nullptr && deletion_queue != nullptr);
+    m_device = device;
+    m_memory_allocator = memory_allocator;
+    m_descriptor_allocator = descriptor_allocator;
+    m_vkCmdBeginRendering = begin_rendering;
+    m_vkCmdEndRendering = end_rendering;
+    m_state_tracker = state_tracker;
+    m_deletion_queue = deletion_queue;
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(MAX_PASS_INPUTS);
+    for (uint32_t i = 0; i < MAX_PASS_INPUTS; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    m_input_set_layout = layout_cache->layout(bindings);
+
+    VkSamplerCreateInfo sampler_info{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = 0.0f;
+    VkResult result;
+    result = vkCreateSampler(m_device, &sampler_info, nullptr, &m_input_sampler);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create render graph input sampler!";
+    }
+    assert(result == VK_SUCCESS);
+}
+
+void SeRenderGraph::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // The caller has waited for the device to become idle
+    destroyTransientImages();
+    vkDestroySampler(m_device, m_input_sampler, nullptr);
+    m_input_sampler = VK_NULL_HANDLE;
+    m_input_set_layout = VK_NULL_HANDLE;
+    m_descriptor_allocator = nullptr;
+    m_resources.clear();
+    m_passes.clear();
+    m_dirty = true;
+    m_device = VK_NULL_HANDLE;
+}
+
+VkDescriptorSetLayout SeRenderGraph::inputSetLayout() const {
+    return m_input_set_layout;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Declaration
+void SeRenderGraph::clear() {
+    m_resources.clear();
+    m_passes.clear();
+    m_dirty = true;
+}
+
+SeRenderGraph::ResourceHandle SeRenderGraph::importImage(const QString &name, VkFormat format) {
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.format = format;
+    m_resources.push_back(resource);
+    m_dirty = true;
+    return static_cast<ResourceHandle>(m_resources.size() - 1);
+}
+
+SeRenderGraph::ResourceHandle SeRenderGraph::createImage(const QString &name, VkFormat format, float scale, VkImageUsageFlags extra_usage) {
+    return addImage(name, format, scale, extra_usage, false);
+}
+
+SeRenderGraph::ResourceHandle SeRenderGraph::createHistoryImage(const QString &name, VkFormat format, float scale) {
+    // History is usually shown by copying it to the swap chain
+    return addImage(name, format, scale, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true);
+}
+
+SeRenderGraph::ResourceHandle SeRenderGraph::addImage(const QString &name, VkFormat format, float scale, VkImageUsageFlags extra_usage, bool history) {
+    assert(scale > 0.0f);
+    Resource resource;
+    resource.name = name;
+    resource.format = format;
+    resource.scale = scale;
+    resource.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | extra_usage;
+    resource.history = history;
+    m_resources.push_back(resource);
+    m_dirty = true;
+    return static_cast<ResourceHandle>(m_resources.size() - 1);
+}
+
+void SeRenderGraph::discardHistory(ResourceHandle resource) {
+    assert(resource < m_resources.size() && m_resources[resource].history);
+    m_resources[resource].discard = true;
+}
+
+VkImage SeRenderGraph::image(ResourceHandle resource) const {
+    assert(resource < m_resources.size());
+    return m_resources[resource].image;
+}
+
+SeRenderGraph::PassHandle SeRenderGraph::addPass(const QString &name, const std::vector<ResourceHandle> &reads, const std::vector<ResourceHandle> &writes, RecordFunction &&record_function) {
+    assert(!writes.empty() && reads.size() <= MAX_PASS_INPUTS);
+
+    // Passes execute in declaration order, so every input has to be
+    // produced by an earlier pass and every image has a single producer
+    for (auto resource : reads) {
+        assert(resource < m_resources.size() && !m_resources[resource].imported && m_resources[resource].producer >= 0);
+    }
+    for (auto resource : writes) {
+        assert(resource < m_resources.size() && m_resources[resource].producer < 0);
+        m_resources[resource].producer = static_cast<int>(m_passes.size());
+    }
+
+    Pass pass;
+    pass.name = name;
+    pass.reads = reads;
+    pass.writes = writes;
+    pass.record_function = std::move(record_function);
+    m_passes.push_back(std::move(pass));
+    m_dirty = true;
+    return static_cast<PassHandle>(m_passes.size() - 1);
+}
+
+void SeRenderGraph::setPassCacheKey(PassHandle pass, KeyFunction &&key_function) {
+    assert(pass < m_passes.size());
+    // Swap chain images change every frame, only transient outputs persist
+    for (auto resource : m_passes[pass].writes) {
+        assert(!m_resources[resource].imported);
+    }
+    m_passes[pass].key_function = std::move(key_function);
+    m_dirty = true;
+}
+
+void SeRenderGraph::setPassMultisampleTarget(PassHandle pass, VkImage image, VkImageView view, VkSampleCountFlagBits samples) {
+    // Set every frame like imported images, the image is the caller's and
+    // has to be registered with the state tracker and sized like the extent
+    assert(pass < m_passes.size());
+    Pass &multisampled = m_passes[pass];
+    assert(samples == VK_SAMPLE_COUNT_1_BIT || (image != VK_NULL_HANDLE && multisampled.writes.size() == 1 && !m_resources[multisampled.writes[0]].history));
+    multisampled.samples = samples;
+    multisampled.multisample_image = image;
+    multisampled.multisample_view = view;
+}
+
+void SeRenderGraph::markOutput(ResourceHandle resource) {
+    assert(resource < m_resources.size());
+    m_resources[resource].output = true;
+    m_dirty = true;
+}
+
+void SeRenderGraph::setExtent(VkExtent2D extent) {
+    if (extent.width != m_extent.width || extent.height != m_extent.height) {
+        m_extent = extent;
+        m_dirty = true;
+    }
+}
+
+void SeRenderGraph::setImportedImage(ResourceHandle resource, VkImage image, VkImageView view, VkFormat format) {
+    assert(resource < m_resources.size() && m_resources[resource].imported);
+    Resource &imported = m_resources[resource];
+    imported.image = image;
+    imported.view = view;
+    if (imported.format != format) {
+        // Attachment formats are baked into the compiled passes
+        imported.format = format;
+        m_dirty = true;
+    }
+}
+
+#pragma endregion Declaration
+
+#pragma region Compilation
+bool SeRenderGraph::compile(uint64_t last_submitted_frame) {
+    if (!m_dirty) {
+        return false;
+    }
+    assert(m_device != VK_NULL_HANDLE && m_extent.width > 0 && m_extent.height > 0);
+
+    retireTransientImages(last_submitted_frame);
+    cullPasses();
+    computeLifetimes();
+    allocateTransientImages();
+    m_dirty = false;
+
+    qDebug() << "Render graph compiled:" << activePassCount() << "passes," << culledPassCount() << "culled,"
+             << m_transient_memory_size / 1024 << "KiB transient memory";
+    return true;
+}
+
+void SeRenderGraph::cullPasses() {
+    // Walk backwards from the outputs, a pass survives when something
+    // downstream consumes one of its writes
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t i = 0; i < m_resources.size(); i++) {
+        needed[i] = m_resources[i].output;
+    }
+    for (size_t i = m_passes.size(); i-- > 0;) {
+        Pass &pass = m_passes[i];
+        pass.culled = std::none_of(pass.writes.begin(), pass.writes.end(), [&needed](ResourceHandle resource) { return needed[resource]; });
+        if (pass.culled) {
+            qDebug() << "Render graph pass" << pass.name << "culled";
+            continue;
+        }
+        for (auto resource : pass.reads) {
+            needed[resource] = true;
+        }
+    }
+}
+
+void SeRenderGraph::computeLifetimes() {
+    for (auto &resource : m_resources) {
+        resource.first_use = UINT32_MAX;
+        resource.last_use = 0;
+        resource.persistent = resource.history || (resource.producer >= 0 && m_passes[resource.producer].key_function != nullptr);
+        resource.discard = true;
+        if (!resource.imported) {
+            resource.extent.width = std::max(1u, static_cast<uint32_t>(std::lround(m_extent.width * resource.scale)));
+            resource.extent.height = std::max(1u, static_cast<uint32_t>(std::lround(m_extent.height * resource.scale)));
+        } else {
+            resource.extent = m_extent;
+        }
+    }
+
+    for (uint32_t i = 0; i < m_passes.size(); i++) {
+        Pass &pass = m_passes[i];
+        // New images hold nothing worth keeping
+        pass.cache_valid = false;
+        if (pass.culled) {
+            continue;
+        }
+        auto use = [this, i](ResourceHandle handle) {
+            Resource &resource = m_resources[handle];
+            resource.first_use = std::min(resource.first_use, i);
+            resource.last_use = std::max(resource.last_use, i);
+        };
+        std::for_each(pass.reads.begin(), pass.reads.end(), use);
+        std::for_each(pass.writes.begin(), pass.writes.end(), use);
+
+        pass.extent = m_resources[pass.writes[0]].extent;
+        pass.color_formats.clear();
+        for (auto resource : pass.writes) {
+            assert(m_resources[resource].extent.width == pass.extent.width && m_resources[resource].extent.height == pass.extent.height);
+            pass.color_formats.push_back(m_resources[resource].format);
+        }
+    }
+}
+
+void SeRenderGraph::allocateTransientImages() {
+    struct MemoryBlock {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        uint32_t free_after;
+    };
+
+    std::vector<ResourceHandle> transients;
+    for (ResourceHandle i = 0; i < m_resources.size(); i++) {
+        if (!m_resources[i].imported && m_resources[i].first_use != UINT32_MAX) {
+            transients.push_back(i);
+        }
+    }
+    std::sort(transients.begin(), transients.end(), [this](ResourceHandle a, ResourceHandle b) { return m_resources[a].first_use < m_resources[b].first_use; });
+
+    std::vector<MemoryBlock> blocks;
+    VkDeviceSize unaliased_size = 0;
+    VkMemoryRequirements aliased_requirements{};
+    aliased_requirements.alignment = 1;
+    aliased_requirements.memoryTypeBits = UINT32_MAX;
+    m_transient_memory_size = 0;
+    for (auto handle : transients) {
+        Resource &resource = m_resources[handle];
+
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = resource.format;
+        image_info.extent = {resource.extent.width, resource.extent.height, 1};
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = resource.usage;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkResult result;
+        result = vkCreateImage(m_device, &image_info, nullptr, &resource.image);
+        if (result != VK_SUCCESS) {
+            qDebug() << "Failed to create render graph image" << resource.name << "!";
+        }
+        assert(result == VK_SUCCESS);
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_device, resource.image, &requirements);
+        aliased_requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        aliased_requirements.alignment = std::max(aliased_requirements.alignment, requirements.alignment);
+        unaliased_size += requirements.size;
+
+        // Reuse the smallest block whose occupant is dead before this image
+        // is first written, otherwise grow the allocation. Cached outputs
+        // live across frames and get a block of their own
+        uint32_t free_after = resource.persistent ? UINT32_MAX : resource.last_use;
+        MemoryBlock *best = nullptr;
+        for (auto &block : blocks) {
+            if (!resource.persistent && block.free_after < resource.first_use && block.size >= requirements.size && block.offset % requirements.alignment == 0 &&
+                (best == nullptr || block.size < best->size)) {
+                best = &block;
+            }
+        }
+        if (best != nullptr) {
+            best->free_after = free_after;
+            resource.memory_offset = best->offset;
+        } else {
+            VkDeviceSize offset = (m_transient_memory_size + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+            blocks.push_back({offset, requirements.size, free_after});
+            resource.memory_offset = offset;
+            m_transient_memory_size = offset + requirements.size;
+        }
+    }
+
+    if (transients.empty()) {
+        return;
+    }
+
+    // One range for all transients, the offsets above are relative to it
+    aliased_requirements.size = m_transient_memory_size;
+    m_transient_memory = m_memory_allocator->allocate(aliased_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    if (!m_transient_memory.isValid()) {
+        qDebug() << "Failed to allocate render graph memory!";
+    }
+    assert(m_transient_memory.isValid());
+
+    VkResult result;
+    for (auto handle : transients) {
+        Resource &resource = m_resources[handle];
+        result = vkBindImageMemory(m_device, resource.image, m_transient_memory.memory, m_transient_memory.offset + resource.memory_offset);
+        assert(result == VK_SUCCESS);
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = resource.image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = resource.format;
+        view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        result = vkCreateImageView(m_device, &view_info, nullptr, &resource.view);
+        if (result != VK_SUCCESS) {
+            qDebug() << "Failed to create render graph image view" << resource.name << "!";
+        }
+        assert(result == VK_SUCCESS);
+
+        m_state_tracker->registerImage(resource.image, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, VK_IMAGE_LAYOUT_UNDEFINED);
+    }
+    qDebug() << "Render graph aliasing saved" << (unaliased_size - m_transient_memory_size) / 1024 << "KiB of" << unaliased_size / 1024 << "KiB";
+}
+
+void SeRenderGraph::writeInputSets() {
+    // Sets come from the current frame's pools, which are reset once the
+    // frame has completed, so recompiling never has to retire any
+    for (auto &pass : m_passes) {
+        pass.input_set = VK_NULL_HANDLE;
+        if (pass.culled || pass.skipped || pass.reads.empty()) {
+            continue;
+        }
+        pass.input_set = m_descriptor_allocator->allocate(m_input_set_layout);
+
+        std::vector<VkDescriptorImageInfo> image_infos(pass.reads.size());
+        std::vector<VkWriteDescriptorSet> writes(pass.reads.size());
+        for (size_t i = 0; i < pass.reads.size(); i++) {
+            image_infos[i].sampler = m_input_sampler;
+            image_infos[i].imageView = m_resources[pass.reads[i]].view;
+            image_infos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = pass.input_set;
+            writes[i].dstBinding = static_cast<uint32_t>(i);
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[i].pImageInfo = &image_infos[i];
+        }
+        vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+}
+
+void SeRenderGraph::retireTransientImages(uint64_t last_submitted_frame) {
+    VkDevice device = m_device;
+    SeMemoryAllocator *memory_allocator = m_memory_allocator;
+    SeMemoryAllocator::Allocation memory = m_transient_memory;
+    std::vector<VkImage> images;
+    std::vector<VkImageView> views;
+    for (auto &resource : m_resources) {
+        if (!resource.imported && resource.image != VK_NULL_HANDLE) {
+            m_state_tracker->unregisterImage(resource.image);
+            images.push_back(resource.image);
+            views.push_back(resource.view);
+            resource.image = VK_NULL_HANDLE;
+            resource.view = VK_NULL_HANDLE;
+        }
+    }
+    m_transient_memory = SeMemoryAllocator::Allocation{};
+    if (images.empty()) {
+        return;
+    }
+
+    // Frames in flight still sample the old images
+    m_deletion_queue->retire(last_submitted_frame, [device, memory_allocator, memory, images, views]() mutable {
+        for (auto view : views) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        for (auto image : images) {
+            vkDestroyImage(device, image, nullptr);
+        }
+        memory_allocator->free(memory);
+    });
+}
+
+void SeRenderGraph::destroyTransientImages() {
+    for (auto &resource : m_resources) {
+        if (!resource.imported && resource.image != VK_NULL_HANDLE) {
+            m_state_tracker->unregisterImage(resource.image);
+            vkDestroyImageView(m_device, resource.view, nullptr);
+            vkDestroyImage(m_device, resource.image, nullptr);
+            resource.image = VK_NULL_HANDLE;
+            resource.view = VK_NULL_HANDLE;
+        }
+    }
+    m_memory_allocator->free(m_transient_memory);
+    m_transient_memory_size = 0;
+}
+
+#pragma endregion Compilation
+
+#pragma region Execution
+uint64_t SeRenderGraph::hashCombine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+void SeRenderGraph::updatePassCache() {
+    // Key 0 marks outputs that change every frame, which makes every pass
+    // reading them uncacheable as well
+    std::vector<uint64_t> resource_keys(m_resources.size(), 0);
+    m_skipped_pass_count = 0;
+    for (auto &pass : m_passes) {
+        pass.skipped = false;
+        if (pass.culled) {
+            continue;
+        }
+
+        uint64_t key = 0;
+        if (pass.key_function) {
+            key = hashCombine(0, pass.key_function());
+            for (auto resource : pass.reads) {
+                if (resource_keys[resource] == 0) {
+                    key = 0;
+                    break;
+                }
+                key = hashCombine(key, resource_keys[resource]);
+            }
+        }
+
+        pass.skipped = key != 0 && pass.cache_valid && pass.cached_key == key;
+        pass.cached_key = key;
+        pass.cache_valid = key != 0;
+        for (auto resource : pass.writes) {
+            resource_keys[resource] = key;
+        }
+        if (pass.skipped) {
+            m_skipped_pass_count++;
+        }
+    }
+}
+
+void SeRenderGraph::execute(VkCommandBuffer command_buffer, SeParallelRecorder *recorder) {
+    assert(!m_dirty);
+    updatePassCache();
+    writeInputSets();
+
+    // Pass bodies do not depend on each other while recording, so with a
+    // recorder they are all recorded up front on the worker threads
+    std::vector<VkCommandBuffer> secondary_command_buffers;
+    if (recorder != nullptr) {
+        std::vector<VkCommandBufferInheritanceRenderingInfoKHR> rendering_inheritances;
+        std::vector<VkCommandBufferInheritanceInfo> inheritances;
+        std::vector<SeParallelRecorder::RecordFunction> tasks;
+        rendering_inheritances.reserve(m_passes.size());
+        for (const auto &pass : m_passes) {
+            if (pass.culled || pass.skipped) {
+                continue;
+            }
+            VkCommandBufferInheritanceRenderingInfoKHR rendering_inheritance{};
+            rendering_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+            rendering_inheritance.colorAttachmentCount = static_cast<uint32_t>(pass.color_formats.size());
+            rendering_inheritance.pColorAttachmentFormats = pass.color_formats.data();
+            rendering_inheritance.rasterizationSamples = pass.samples;
+            rendering_inheritances.push_back(rendering_inheritance);
+
+            VkCommandBufferInheritanceInfo inheritance{};
+            inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritance.pNext = &rendering_inheritances.back();
+            inheritances.push_back(inheritance);
+
+            PassContext context{pass.extent, pass.input_set};
+            const RecordFunction &record_function = pass.record_function;
+            tasks.push_back([&record_function, context](VkCommandBuffer secondary_command_buffer) { record_function(secondary_command_buffer, context); });
+        }
+        secondary_command_buffers = recorder->record(inheritances, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, tasks);
+    }
+
+    size_t active_index = 0;
+    for (const auto &pass : m_passes) {
+        // Skipped passes left their outputs in the shader read layout, so
+        // readers need no barrier either
+        if (pass.culled || pass.skipped) {
+            continue;
+        }
+        recordPass(command_buffer, pass, recorder != nullptr ? secondary_command_buffers[active_index] : VK_NULL_HANDLE);
+        active_index++;
+    }
+}
+
+void SeRenderGraph::recordPass(VkCommandBuffer command_buffer, const Pass &pass, VkCommandBuffer secondary_command_buffer) {
+    for (auto handle : pass.reads) {
+        m_state_tracker->requireImage(m_resources[handle].image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
+    }
+
+    std::vector<VkRenderingAttachmentInfoKHR> color_attachments(pass.writes.size());
+    for (size_t i = 0; i < pass.writes.size(); i++) {
+        Resource &resource = m_resources[pass.writes[i]];
+        assert(resource.image != VK_NULL_HANDLE);
+        bool load_contents = resource.history && !resource.discard;
+        if (!resource.imported && !load_contents) {
+            // The producer is the first user in every frame. The contents are
+            // discarded, but the barrier still has to wait for the readers of
+            // the previous frame and of whatever image shared the memory
+            m_state_tracker->resetImage(resource.image, VK_IMAGE_LAYOUT_UNDEFINED,
+                                        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+        }
+        resource.discard = false;
+        VkAccessFlags2 accesses = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        if (load_contents) {
+            accesses |= VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT;
+        }
+        m_state_tracker->requireImage(resource.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, accesses);
+
+        color_attachments[i].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        color_attachments[i].imageView = resource.view;
+        color_attachments[i].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        color_attachments[i].resolveMode = VK_RESOLVE_MODE_NONE;
+        color_attachments[i].loadOp = load_contents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color_attachments[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachments[i].clearValue = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+        if (pass.samples != VK_SAMPLE_COUNT_1_BIT) {
+            // The samples only live for the pass, the output receives their
+            // average in the resolve, which writes at the color attachment
+            // output stage like the draws
+            m_state_tracker->resetImage(pass.multisample_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+            m_state_tracker->requireImage(pass.multisample_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+            color_attachments[i].imageView = pass.multisample_view;
+            color_attachments[i].resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+            color_attachments[i].resolveImageView = resource.view;
+            color_attachments[i].resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            color_attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            color_attachments[i].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+    }
+    m_state_tracker->flush(command_buffer);
+
+    VkRenderingInfoKHR rendering_info{};
+    rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    rendering_info.flags = secondary_command_buffer != VK_NULL_HANDLE ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+    rendering_info.renderArea.offset = {0, 0};
+    rendering_info.renderArea.extent = pass.extent;
+    rendering_info.layerCount = 1;
+    rendering_info.colorAttachmentCount = static_cast<uint32_t>(color_attachments.size());
+    rendering_info.pColorAttachments = color_attachments.data();
+    m_vkCmdBeginRendering(command_buffer, &rendering_info);
+
+    if (secondary_command_buffer != VK_NULL_HANDLE) {
+        vkCmdExecuteCommands(command_buffer, 1, &secondary_command_buffer);
+    } else {
+        pass.record_function(command_buffer, PassContext{pass.extent, pass.input_set});
+    }
+
+    m_vkCmdEndRendering(command_buffer);
+}
+
+#pragma endregion Execution
+
+#pragma region Statistics
+size_t SeRenderGraph::activePassCount() const {
+    return std::count_if(m_passes.begin(), m_passes.end(), [](const Pass &pass) { return !pass.culled; });
+}
+
+size_t SeRenderGraph::culledPassCount() const {
+    return m_passes.size() - activePassCount();
+}
+
+size_t SeRenderGraph::skippedPassCount() const {
+    return m_skipped_pass_count;
+}
+
+VkDeviceSize SeRenderGraph::transientMemorySize() const {
+    return m_transient_memory_size;
+}
+
+#pragma endregion Statistics
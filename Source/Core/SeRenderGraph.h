@@ -0,0 +1,162 @@
+#ifndef SE_RENDER_GRAPH_H
+#define SE_RENDER_GRAPH_H
+
+#include "SeDeletionQueue.h"
+#include "SeDescriptorAllocator.h"
+#include "SeDescriptorLayoutCache.h"
+#include "SeMemoryAllocator.h"
+#include "SeParallelRecorder.h"
+#include "SeResourceStateTracker.h"
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Chains passes that declare the images they read and write, Shadertoy style:
+// buffer passes render into transient images that later passes sample, and
+// the last pass writes the imported swap chain image. The graph is compiled
+// once: passes that do not contribute to a marked output are culled and
+// transient images with disjoint lifetimes share the same device memory.
+// Executing the compiled graph only records barriers and passes and writes
+// their input sets, allocated per frame from the caller's descriptor
+// allocator. The graph is recompiled when the declared topology, the extent or an imported format
+// changes. Passes are recorded with dynamic rendering.
+//
+// A pass with a cache key keeps its outputs across frames and is skipped
+// while the key and the keys of everything it reads are unchanged, so a
+// precompute pass that depends only on constants runs once. Its outputs are
+// never aliased. History images go further and keep their contents between
+// executions, so a pass can blend into what it wrote in earlier frames until
+// the history is discarded.
+//
+// A pass writing a single image can draw multisampled: it renders into a
+// transient multisampled image owned by the caller, which is resolved into
+// its output at the end of the pass and never stored.
+class SeRenderGraph {
+  public:
+    using ResourceHandle = uint32_t;
+    using PassHandle = uint32_t;
+
+    static constexpr ResourceHandle INVALID_RESOURCE = UINT32_MAX;
+    static constexpr PassHandle INVALID_PASS = UINT32_MAX;
+    static constexpr uint32_t MAX_PASS_INPUTS = 4;
+
+    struct PassContext {
+        VkExtent2D extent = {0, 0};
+        // Inputs bound as combined image samplers 0 to MAX_PASS_INPUTS - 1 in
+        // read order, VK_NULL_HANDLE for passes without inputs
+        VkDescriptorSet input_set = VK_NULL_HANDLE;
+    };
+    using RecordFunction = std::function<void(VkCommandBuffer command_buffer, const PassContext &context)>;
+    // Hash of everything besides the inputs that determines the output, at
+    // least the pipeline handle and the parameters the pass reads
+    using KeyFunction = std::function<uint64_t()>;
+
+    static uint64_t hashCombine(uint64_t seed, uint64_t value);
+
+    SeRenderGraph();
+    ~SeRenderGraph();
+
+    void init(VkDevice device, SeMemoryAllocator *memory_allocator, SeDescriptorLayoutCache *layout_cache, SeDescriptorAllocator *descriptor_allocator, PFN_vkCmdBeginRenderingKHR begin_rendering, PFN_vkCmdEndRenderingKHR end_rendering, SeResourceStateTracker *state_tracker, SeDeletionQueue *deletion_queue);
+    void cleanup();
+    VkDescriptorSetLayout inputSetLayout() const;
+
+    void clear();
+    ResourceHandle importImage(const QString &name, VkFormat format);
+    ResourceHandle createImage(const QString &name, VkFormat format, float scale = 1.0f, VkImageUsageFlags extra_usage = 0);
+    ResourceHandle createHistoryImage(const QString &name, VkFormat format, float scale = 1.0f);
+    void discardHistory(ResourceHandle resource);
+    VkImage image(ResourceHandle resource) const;
+    PassHandle addPass(const QString &name, const std::vector<ResourceHandle> &reads, const std::vector<ResourceHandle> &writes, RecordFunction &&record_function);
+    void setPassCacheKey(PassHandle pass, KeyFunction &&key_function);
+    void setPassMultisampleTarget(PassHandle pass, VkImage image, VkImageView view, VkSampleCountFlagBits samples);
+    void markOutput(ResourceHandle resource);
+
+    void setExtent(VkExtent2D extent);
+    void setImportedImage(ResourceHandle resource, VkImage image, VkImageView view, VkFormat format);
+
+    bool compile(uint64_t last_submitted_frame);
+    void execute(VkCommandBuffer command_buffer, SeParallelRecorder *recorder = nullptr);
+
+    size_t activePassCount() const;
+    size_t culledPassCount() const;
+    size_t skippedPassCount() const;
+    VkDeviceSize transientMemorySize() const;
+
+  private:
+    struct Resource {
+        QString name;
+        bool imported = false;
+        bool output = false;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        float scale = 1.0f;
+        VkImageUsageFlags usage = 0;
+        int producer = -1;
+        bool persistent = false;
+        bool history = false;
+        bool discard = true;
+
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkExtent2D extent = {0, 0};
+        uint32_t first_use = UINT32_MAX;
+        uint32_t last_use = 0;
+        VkDeviceSize memory_offset = 0;
+    };
+
+    struct Pass {
+        QString name;
+        std::vector<ResourceHandle> reads;
+        std::vector<ResourceHandle> writes;
+        RecordFunction record_function;
+        KeyFunction key_function;
+
+        bool culled = false;
+        bool skipped = false;
+        bool cache_valid = false;
+        uint64_t cached_key = 0;
+        VkExtent2D extent = {0, 0};
+        std::vector<VkFormat> color_formats;
+        VkDescriptorSet input_set = VK_NULL_HANDLE;
+
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+        VkImage multisample_image = VK_NULL_HANDLE;
+        VkImageView multisample_view = VK_NULL_HANDLE;
+    };
+
+    SeRenderGraph(const SeRenderGraph &) = delete;
+    SeRenderGraph &operator=(const SeRenderGraph &) = delete;
+
+    void cullPasses();
+    void computeLifetimes();
+    void allocateTransientImages();
+    void writeInputSets();
+    void retireTransientImages(uint64_t last_submitted_frame);
+    void destroyTransientImages();
+    void updatePassCache();
+    void recordPass(VkCommandBuffer command_buffer, const Pass &pass, VkCommandBuffer secondary_command_buffer);
+    ResourceHandle addImage(const QString &name, VkFormat format, float scale, VkImageUsageFlags extra_usage, bool history);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    SeMemoryAllocator *m_memory_allocator = nullptr;
+    SeDescriptorAllocator *m_descriptor_allocator = nullptr;
+    PFN_vkCmdBeginRenderingKHR m_vkCmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR m_vkCmdEndRendering = nullptr;
+    SeResourceStateTracker *m_state_tracker = nullptr;
+    SeDeletionQueue *m_deletion_queue = nullptr;
+
+    VkDescriptorSetLayout m_input_set_layout = VK_NULL_HANDLE;
+    VkSampler m_input_sampler = VK_NULL_HANDLE;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    VkExtent2D m_extent = {0, 0};
+    bool m_dirty = true;
+    size_t m_skipped_pass_count = 0;
+
+    SeMemoryAllocator::Allocation m_transient_memory;
+    VkDeviceSize m_transient_memory_size = 0;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "SeRenderScheduler.h"
+
+#pragma region Dirty tracking
+void SeRenderScheduler::markDirty(uint32_t flags) {
+    m_dirty_flags |= flags;
+}
+
+uint32_t SeRenderScheduler::dirtyFlags() const {
+    return m_dirty_flags;
+}
+
+uint32_t SeRenderScheduler::takeDirtyFlags() {
+    uint32_t flags = m_dirty_flags;
+    m_dirty_flags = DIRTY_NONE;
+    return flags;
+}
+
+#pragma endregion Dirty tracking
+
+#pragma region Visibility and time dependency
+void SeRenderScheduler::setVisible(bool visible) {
+    if (visible && !m_visible) {
+        // Content is undefined after the window was hidden or minimized
+        m_dirty_flags |= DIRTY_EXPOSE;
+    }
+    m_visible = visible;
+}
+
+bool SeRenderScheduler::isVisible() const {
+    return m_visible;
+}
+
+void SeRenderScheduler::setTimeDependent(bool time_dependent) {
+    m_time_dependent = time_dependent;
+}
+
+bool SeRenderScheduler::isTimeDependent() const {
+    return m_time_dependent;
+}
+
+void SeRenderScheduler::setContinuous(bool continuous) {
+    m_continuous = continuous;
+}
+
+bool SeRenderScheduler::isContinuous() const {
+    return m_continuous;
+}
+
+bool SeRenderScheduler::needsFrame() const {
+    if (!m_visible) {
+        return false;
+    }
+    return m_time_dependent || m_continuous || m_dirty_flags != DIRTY_NONE;
+}
+
+#pragma endregion Visibility and time dependency
+
+#pragma region Statistics
+void SeRenderScheduler::frameRendered() {
+    m_rendered_frame_count++;
+}
+
+void SeRenderScheduler::frameSkipped() {
+    m_skipped_frame_count++;
+}
+
+uint64_t SeRenderScheduler::renderedFrameCount() const {
+    return m_rendered_frame_count;
+}
+
+uint64_t SeRenderScheduler::skippedFrameCount() const {
+    return m_skipped_frame_count;
+}
+
+#pragma endregion Statistics
@@ -0,0 +1,50 @@
+#ifndef SE_RENDER_SCHEDULER_H
+#define SE_RENDER_SCHEDULER_H
+
+#include <cstdint>
+
+// Decides whether SeVulkanWindow needs to render a new frame. Frames are only
+// produced when something visible changed, or continuously while the current
+// shader depends on time or a measurement needs back-to-back frames. Nothing is
+// rendered while the window is hidden.
+class SeRenderScheduler {
+  public:
+    enum DirtyFlag : uint32_t {
+        DIRTY_NONE = 0,
+        DIRTY_EXPOSE = 1 << 0,
+        DIRTY_SWAP_CHAIN = 1 << 1,
+        DIRTY_SHADER = 1 << 2,
+        DIRTY_PARAMETERS = 1 << 3,
+        DIRTY_ALL = DIRTY_EXPOSE | DIRTY_SWAP_CHAIN | DIRTY_SHADER | DIRTY_PARAMETERS
+    };
+
+    void markDirty(uint32_t flags);
+    uint32_t dirtyFlags() const;
+    uint32_t takeDirtyFlags();
+
+    void setVisible(bool visible);
+    bool isVisible() const;
+
+    void setTimeDependent(bool time_dependent);
+    bool isTimeDependent() const;
+
+    void setContinuous(bool continuous);
+    bool isContinuous() const;
+
+    bool needsFrame() const;
+
+    void frameRendered();
+    void frameSkipped();
+    uint64_t renderedFrameCount() const;
+    uint64_t skippedFrameCount() const;
+
+  private:
+    uint32_t m_dirty_flags = DIRTY_ALL;
+    bool m_visible = false;
+    bool m_time_dependent = false;
+    bool m_continuous = false;
+    uint64_t m_rendered_frame_count = 0;
+    uint64_t m_skipped_frame_count = 0;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "SeResidencyManager.h"
+#include <QDebug>
+#include <algorithm>
+#include <map>
+
+#pragma region Init and cleanup
+SeResidencyManager::SeResidencyManager() {
+}
+
+SeResidencyManager::~SeResidencyManager() {
+    cleanup();
+}
+
+void SeResidencyManager::init(SeMemoryAllocator *memory_allocator) {
+    assert(memory_allocator != nullptr);
+    m_memory_allocator = memory_allocator;
+    m_budgets = m_memory_allocator->heapBudgets();
+    m_logged_usage.assign(m_budgets.size(), 0);
+    for (size_t i = 0; i < m_budgets.size(); i++) {
+        m_logged_usage[i] = m_budgets[i].usage;
+    }
+    m_frame_number = UINT64_MAX;
+    m_cooldown = 0;
+    m_trim_pending = false;
+    printBudgets();
+}
+
+void SeResidencyManager::cleanup() {
+    if (m_memory_allocator == nullptr) {
+        return;
+    }
+    // Owners take their entries back before the device goes away
+    if (entryCount() > 0) {
+        qDebug() << entryCount() << "resident entries left behind!";
+    }
+    m_entries.clear();
+    m_free_handles.clear();
+    m_budgets.clear();
+    m_logged_usage.clear();
+    m_memory_allocator = nullptr;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Entries
+SeResidencyManager::EntryHandle SeResidencyManager::add(const SeMemoryAllocator::Allocation &allocation, Evictor &&evictor) {
+    assert(m_memory_allocator != nullptr && allocation.isValid());
+    EntryHandle handle;
+    if (!m_free_handles.empty()) {
+        handle = m_free_handles.back();
+        m_free_handles.pop_back();
+    } else {
+        handle = static_cast<EntryHandle>(m_entries.size());
+        m_entries.emplace_back();
+    }
+
+    Entry &entry = m_entries[handle];
+    entry.live = true;
+    entry.heap = m_memory_allocator->heapIndex(allocation.memory_type);
+    entry.allocation = allocation;
+    entry.last_use = ++m_use_counter;
+    entry.evictor = std::move(evictor);
+    return handle;
+}
+
+void SeResidencyManager::touch(EntryHandle handle) {
+    assert(handle < m_entries.size() && m_entries[handle].live);
+    m_entries[handle].last_use = ++m_use_counter;
+}
+
+void SeResidencyManager::remove(EntryHandle handle) {
+    assert(handle < m_entries.size() && m_entries[handle].live);
+    m_entries[handle] = Entry{};
+    m_free_handles.push_back(handle);
+}
+
+size_t SeResidencyManager::entryCount() const {
+    return m_entries.size() - m_free_handles.size();
+}
+
+#pragma endregion Entries
+
+#pragma region Budget
+void SeResidencyManager::update(uint64_t device_frame_number) {
+    // Windows sharing the device would otherwise count down the cooldown
+    // once each per frame
+    if (m_memory_allocator == nullptr || device_frame_number == m_frame_number) {
+        return;
+    }
+    m_frame_number = device_frame_number;
+    m_budgets = m_memory_allocator->heapBudgets();
+    bool usage_changed = false;
+    for (size_t i = 0; i < m_budgets.size(); i++) {
+        VkDeviceSize usage = m_budgets[i].usage;
+        VkDeviceSize logged = m_logged_usage[i];
+        usage_changed |= (usage > logged ? usage - logged : logged - usage) >= LOG_THRESHOLD;
+    }
+    if (usage_changed) {
+        printBudgets();
+        for (size_t i = 0; i < m_budgets.size(); i++) {
+            m_logged_usage[i] = m_budgets[i].usage;
+        }
+    }
+
+    // Earlier evictions are not reflected in the usage yet
+    if (m_cooldown > 0) {
+        m_cooldown--;
+        if (m_cooldown == 0 && m_trim_pending) {
+            // The deletion queue has freed the evicted resources by now,
+            // the allocator would keep their last empty blocks otherwise
+            m_memory_allocator->trim();
+            m_trim_pending = false;
+        }
+        return;
+    }
+    bool trimmed = false;
+    for (uint32_t heap = 0; heap < m_budgets.size(); heap++) {
+        const SeMemoryAllocator::HeapBudget &budget = m_budgets[heap];
+        if (budget.budget == 0 || static_cast<double>(budget.usage) <= budget.budget * HIGH_WATERMARK) {
+            continue;
+        }
+        VkDeviceSize target_bytes = budget.usage - static_cast<VkDeviceSize>(budget.budget * LOW_WATERMARK);
+        VkDeviceSize released_bytes = 0;
+        if (!trimmed) {
+            // Empty blocks cost nothing to give back, the freed bytes may
+            // belong to other heaps too so the next round checks again
+            released_bytes = m_memory_allocator->trim();
+            trimmed = true;
+        }
+        if (released_bytes < target_bytes) {
+            released_bytes += evict(heap, target_bytes - released_bytes);
+        }
+        qDebug() << "Heap" << heap << "at" << budget.usage / (1024 * 1024) << "of" << budget.budget / (1024 * 1024) << "MiB budget, released" << released_bytes / (1024 * 1024) << "MiB";
+        m_cooldown = EVICTION_COOLDOWN;
+    }
+}
+
+VkDeviceSize SeResidencyManager::evict(uint32_t heap, VkDeviceSize target_bytes) {
+    // Freeing a sub-allocation gives nothing back while its block holds
+    // other resources, so entries are evicted per device memory object
+    std::map<VkDeviceMemory, EvictionGroup> groups_by_memory;
+    for (EntryHandle i = 0; i < m_entries.size(); i++) {
+        const Entry &entry = m_entries[i];
+        if (entry.live && entry.heap == heap) {
+            EvictionGroup &group = groups_by_memory[entry.allocation.memory];
+            group.entries.push_back(i);
+            group.last_use = std::max(group.last_use, entry.last_use);
+        }
+    }
+
+    // Groups that return nothing, like blocks shared with resources in use,
+    // are not worth evicting
+    std::vector<EvictionGroup> groups;
+    for (auto &group_by_memory : groups_by_memory) {
+        EvictionGroup &group = group_by_memory.second;
+        std::vector<SeMemoryAllocator::Allocation> allocations;
+        for (EntryHandle handle : group.entries) {
+            allocations.push_back(m_entries[handle].allocation);
+        }
+        group.releasable_bytes = m_memory_allocator->releasableBytes(allocations);
+        if (group.releasable_bytes > 0) {
+            groups.push_back(std::move(group));
+        }
+    }
+    std::sort(groups.begin(), groups.end(), [](const EvictionGroup &a, const EvictionGroup &b) { return a.last_use < b.last_use; });
+
+    VkDeviceSize evicted_bytes = 0;
+    for (const EvictionGroup &group : groups) {
+        if (evicted_bytes >= target_bytes) {
+            break;
+        }
+        for (EntryHandle handle : group.entries) {
+            // The entry is gone before its owner hears about it
+            Evictor evictor = std::move(m_entries[handle].evictor);
+            remove(handle);
+            evictor();
+        }
+        evicted_bytes += group.releasable_bytes;
+        m_trim_pending = true;
+    }
+    return evicted_bytes;
+}
+
+const std::vector<SeMemoryAllocator::HeapBudget> &SeResidencyManager::heapBudgets() const {
+    return m_budgets;
+}
+
+void SeResidencyManager::printBudgets() const {
+    for (size_t i = 0; i < m_budgets.size(); i++) {
+        const SeMemoryAllocator::HeapBudget &budget = m_budgets[i];
+        qDebug() << "Heap" << i << (budget.device_local ? "(device local):" : "(host):") << budget.usage / (1024 * 1024) << "of" << budget.budget / (1024 * 1024) << "MiB budget used,"
+                 << budget.allocated / (1024 * 1024) << "MiB by this process' allocator," << budget.size / (1024 * 1024) << "MiB total";
+    }
+}
+
+#pragma endregion Budget
@@ -0,0 +1,84 @@
+#ifndef SE_RESIDENCY_MANAGER_H
+#define SE_RESIDENCY_MANAGER_H
+
+#include "SeMemoryAllocator.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Keeps device memory use under the budget of every heap. Owners register
+// resources that no frame needs anymore but that are worth keeping around, such
+// as textures of channels that were switched away from, together with a
+// callback that drops them through the owner's deletion queue; the owner frees
+// them as soon as its frames using them have completed, even when it is idle.
+// update() is called from every window's frame but runs once per device frame:
+// it queries the heap budgets and, for every heap whose usage rises above
+// HIGH_WATERMARK of its budget, first releases the allocator's empty blocks and
+// then evicts entries of that heap until the estimate falls below
+// LOW_WATERMARK. Only memory that goes back to the driver counts: entries are
+// evicted together per device memory object, dedicated allocations and blocks
+// holding nothing but evictable entries, least recently used first; blocks
+// shared with live resources are left alone. Freed memory only shows up in the
+// budget once the frames in flight have completed, so evictions pause for a few
+// device frames after each round and the blocks they emptied are trimmed when
+// the pause ends. Usage per heap is logged whenever it moves noticeably.
+class SeResidencyManager {
+  public:
+    using EntryHandle = uint32_t;
+    using Evictor = std::function<void()>;
+    static constexpr EntryHandle INVALID_ENTRY = UINT32_MAX;
+
+    SeResidencyManager();
+    ~SeResidencyManager();
+
+    void init(SeMemoryAllocator *memory_allocator);
+    void cleanup();
+
+    EntryHandle add(const SeMemoryAllocator::Allocation &allocation, Evictor &&evictor);
+    void touch(EntryHandle entry);
+    void remove(EntryHandle entry);
+    void update(uint64_t device_frame_number);
+
+    const std::vector<SeMemoryAllocator::HeapBudget> &heapBudgets() const;
+    size_t entryCount() const;
+    void printBudgets() const;
+
+  private:
+    static constexpr double HIGH_WATERMARK = 0.9;
+    static constexpr double LOW_WATERMARK = 0.8;
+    static constexpr uint32_t EVICTION_COOLDOWN = 4;
+    static constexpr VkDeviceSize LOG_THRESHOLD = 64 * 1024 * 1024;
+
+    struct Entry {
+        bool live = false;
+        uint32_t heap = 0;
+        SeMemoryAllocator::Allocation allocation;
+        uint64_t last_use = 0;
+        Evictor evictor;
+    };
+
+    // Entries sharing one device memory object, evicted together
+    struct EvictionGroup {
+        std::vector<EntryHandle> entries;
+        VkDeviceSize releasable_bytes = 0;
+        uint64_t last_use = 0;
+    };
+
+    SeResidencyManager(const SeResidencyManager &) = delete;
+    SeResidencyManager &operator=(const SeResidencyManager &) = delete;
+
+    VkDeviceSize evict(uint32_t heap, VkDeviceSize target_bytes);
+
+    SeMemoryAllocator *m_memory_allocator = nullptr;
+    std::vector<Entry> m_entries;
+    std::vector<EntryHandle> m_free_handles;
+    uint64_t m_use_counter = 0;
+    std::vector<SeMemoryAllocator::HeapBudget> m_budgets;
+    std::vector<VkDeviceSize> m_logged_usage;
+    uint64_t m_frame_number = UINT64_MAX;
+    uint32_t m_cooldown = 0;
+    bool m_trim_pending = false;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "SeResolutionScaler.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+#pragma region Settings
+void SeResolutionScaler::setTargetFrameTimeMs(double target_ms) {
+    assert(target_ms > 0.0);
+    m_target_ms = target_ms;
+    m_over_count = 0;
+    m_under_count = 0;
+}
+
+double SeResolutionScaler::targetFrameTimeMs() const {
+    return m_target_ms;
+}
+
+void SeResolutionScaler::reset() {
+    m_scale_steps = MAX_SCALE_STEPS;
+    m_average_ms = 0.0;
+    m_over_count = 0;
+    m_under_count = 0;
+}
+
+#pragma endregion Settings
+
+#pragma region Feedback loop
+bool SeResolutionScaler::recordGpuTime(double gpu_ms) {
+    if (gpu_ms <= 0.0) {
+        return false;
+    }
+    m_average_ms = m_average_ms > 0.0 ? m_average_ms + (gpu_ms - m_average_ms) * SMOOTHING : gpu_ms;
+
+    // GPU time of a full screen shader grows with the pixel count, which is
+    // the square of the scale
+    double steps = static_cast<double>(m_scale_steps);
+    double predicted_up_ms = m_average_ms * (steps + 1.0) * (steps + 1.0) / (steps * steps);
+    if (m_average_ms > m_target_ms * DOWNSCALE_THRESHOLD && m_scale_steps > MIN_SCALE_STEPS) {
+        m_over_count++;
+        m_under_count = 0;
+    } else if (m_scale_steps < MAX_SCALE_STEPS && predicted_up_ms < m_target_ms * UPSCALE_THRESHOLD) {
+        m_under_count++;
+        m_over_count = 0;
+    } else {
+        m_over_count = 0;
+        m_under_count = 0;
+    }
+
+    uint32_t next_steps = m_scale_steps;
+    if (m_over_count >= DOWNSCALE_FRAMES) {
+        // Jump straight to the scale predicted to fit, at least one step
+        double fitting_steps = steps * std::sqrt(m_target_ms / m_average_ms);
+        next_steps = std::min(static_cast<uint32_t>(fitting_steps), m_scale_steps - 1);
+    } else if (m_under_count >= UPSCALE_FRAMES) {
+        // Rise one step at a time, overshooting costs a visible hitch
+        next_steps = m_scale_steps + 1;
+    } else {
+        return false;
+    }
+    next_steps = std::clamp(next_steps, MIN_SCALE_STEPS, MAX_SCALE_STEPS);
+
+    m_over_count = 0;
+    m_under_count = 0;
+    if (next_steps == m_scale_steps) {
+        return false;
+    }
+    // Keep the running average meaningful at the new scale
+    double next = static_cast<double>(next_steps);
+    m_average_ms *= (next * next) / (steps * steps);
+    qDebug() << "Render scale" << scale() << "->" << next_steps * SCALE_STEP << "for" << m_target_ms << "ms target";
+    m_scale_steps = next_steps;
+    return true;
+}
+
+float SeResolutionScaler::scale() const {
+    return m_scale_steps * SCALE_STEP;
+}
+
+VkExtent2D SeResolutionScaler::scaledExtent(VkExtent2D extent) const {
+    VkExtent2D scaled;
+    scaled.width = std::max(1u, extent.width * m_scale_steps / MAX_SCALE_STEPS);
+    scaled.height = std::max(1u, extent.height * m_scale_steps / MAX_SCALE_STEPS);
+    return scaled;
+}
+
+#pragma endregion Feedback loop
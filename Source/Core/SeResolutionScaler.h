@@ -0,0 +1,41 @@
+#ifndef SE_RESOLUTION_SCALER_H
+#define SE_RESOLUTION_SCALER_H
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+// Picks the render scale of the preview from measured GPU frame times so a
+// heavy shader holds a target frame time. The loop has hysteresis: the scale
+// only drops after several frames over the target and only rises after many
+// frames in which the next larger scale is predicted to fit comfortably,
+// so it settles instead of oscillating between two steps.
+class SeResolutionScaler {
+  public:
+    void setTargetFrameTimeMs(double target_ms);
+    double targetFrameTimeMs() const;
+    void reset();
+
+    bool recordGpuTime(double gpu_ms);
+    float scale() const;
+    VkExtent2D scaledExtent(VkExtent2D extent) const;
+
+  private:
+    static constexpr double DEFAULT_TARGET_MS = 12.0;
+    // The scale moves in steps of 5%, kept as an integer to avoid drift
+    static constexpr float SCALE_STEP = 0.05f;
+    static constexpr uint32_t MIN_SCALE_STEPS = 5;
+    static constexpr uint32_t MAX_SCALE_STEPS = 20;
+    static constexpr double DOWNSCALE_THRESHOLD = 1.05;
+    static constexpr double UPSCALE_THRESHOLD = 0.9;
+    static constexpr uint32_t DOWNSCALE_FRAMES = 4;
+    static constexpr uint32_t UPSCALE_FRAMES = 30;
+    static constexpr double SMOOTHING = 0.25;
+
+    double m_target_ms = DEFAULT_TARGET_MS;
+    uint32_t m_scale_steps = MAX_SCALE_STEPS;
+    double m_average_ms = 0.0;
+    uint32_t m_over_count = 0;
+    uint32_t m_under_count = 0;
+};
+
+#endif
@@ -0,0 +1,425 @@
+#include "SeResourceStateTracker.h"
+#include <algorithm>
+
+#pragma region Init and cleanup
+void SeResourceStateTracker::init(PFN_vkCmdPipelineBarrier2KHR cmd_pipeline_barrier2) {
+    // Without synchronization2 the barriers are lowered to the legacy command
+    m_vkCmdPipelineBarrier2 = cmd_pipeline_barrier2;
+}
+
+void SeResourceStateTracker::clear() {
+    m_images.clear();
+    m_buffers.clear();
+    m_image_barriers.clear();
+    m_buffer_barriers.clear();
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region State transitions
+VkAccessFlags2 SeResourceStateTracker::writeAccesses(VkAccessFlags2 accesses) {
+    const VkAccessFlags2 write_mask = VK_ACCESS_2_SHADER_WRITE_BIT |
+                                      VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                                      VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                      VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                      VK_ACCESS_2_TRANSFER_WRITE_BIT |
+                                      VK_ACCESS_2_HOST_WRITE_BIT |
+                                      VK_ACCESS_2_MEMORY_WRITE_BIT;
+    return accesses & write_mask;
+}
+
+bool SeResourceStateTracker::needsBarrier(const ResourceState &current, const Access &required) {
+    if (current.layout != required.layout) {
+        return true;
+    }
+    // Write after write and write after read wait for every earlier access
+    if (writeAccesses(required.accesses) != 0) {
+        return current.write_stages != VK_PIPELINE_STAGE_2_NONE || current.read_stages != VK_PIPELINE_STAGE_2_NONE;
+    }
+    // Read after write only when the write is not visible to this reader yet
+    if (current.write_stages == VK_PIPELINE_STAGE_2_NONE) {
+        return false;
+    }
+    return (required.stages & ~current.read_stages) != 0 || (required.accesses & ~current.read_accesses) != 0;
+}
+
+SeResourceStateTracker::BarrierScope SeResourceStateTracker::barrierScope(const ResourceState &current, const Access &required) {
+    BarrierScope scope;
+    scope.src_accesses = current.write_accesses;
+    if (current.layout != required.layout || writeAccesses(required.accesses) != 0) {
+        scope.src_stages = current.write_stages | current.read_stages;
+        scope.dst_stages = required.stages;
+        scope.dst_accesses = required.accesses;
+    } else {
+        // A new reader widens the readers the write was made visible to, so
+        // the latest barrier always covers every stage and access pair
+        scope.src_stages = current.write_stages;
+        scope.dst_stages = current.read_stages | required.stages;
+        scope.dst_accesses = current.read_accesses | required.accesses;
+    }
+    return scope;
+}
+
+SeResourceStateTracker::ResourceState SeResourceStateTracker::nextState(const ResourceState &current, const Access &required) {
+    ResourceState next;
+    next.layout = required.layout;
+    VkAccessFlags2 write_accesses = writeAccesses(required.accesses);
+    if (write_accesses != 0) {
+        next.write_stages = required.stages;
+        next.write_accesses = write_accesses;
+        return next;
+    }
+    if (current.layout != required.layout) {
+        // The transition is a write the barrier made visible to this reader
+        next.write_stages = required.stages;
+        next.read_stages = required.stages;
+        next.read_accesses = required.accesses;
+        return next;
+    }
+    // Reads accumulate so a later write waits for all of them
+    next = current;
+    next.read_stages |= required.stages;
+    next.read_accesses |= required.accesses;
+    return next;
+}
+
+#pragma endregion State transitions
+
+#pragma region Images
+void SeResourceStateTracker::registerImage(VkImage image, VkImageAspectFlags aspect_mask, uint32_t mip_levels, uint32_t array_layers, VkImageLayout initial_layout) {
+    assert(image != VK_NULL_HANDLE && mip_levels > 0 && array_layers > 0);
+
+    ImageState image_state;
+    image_state.aspect_mask = aspect_mask;
+    image_state.mip_levels = mip_levels;
+    image_state.array_layers = array_layers;
+    ResourceState initial_state;
+    initial_state.layout = initial_layout;
+    image_state.subresources.assign(mip_levels * array_layers, initial_state);
+    m_images[image] = std::move(image_state);
+}
+
+void SeResourceStateTracker::unregisterImage(VkImage image) {
+    m_images.erase(image);
+}
+
+void SeResourceStateTracker::resetImage(VkImage image, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses) {
+    auto itr = m_images.find(image);
+    assert(itr != m_images.end());
+    VkImageSubresourceRange range = {itr->second.aspect_mask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    resetImage(image, range, layout, stages, accesses);
+}
+
+void SeResourceStateTracker::resetImage(VkImage image, const VkImageSubresourceRange &range, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses) {
+    // For state established outside the tracker, e.g. by acquire or a render pass
+    auto itr = m_images.find(image);
+    assert(itr != m_images.end());
+    ImageState &image_state = itr->second;
+    ResourceState state;
+    state.layout = layout;
+    if (writeAccesses(accesses) != 0 || accesses == VK_ACCESS_2_NONE) {
+        // An access without memory, like a semaphore wait, orders like a write
+        state.write_stages = stages;
+        state.write_accesses = writeAccesses(accesses);
+    } else {
+        state.read_stages = stages;
+        state.read_accesses = accesses;
+    }
+
+    uint32_t mip_end = range.levelCount == VK_REMAINING_MIP_LEVELS ? image_state.mip_levels : range.baseMipLevel + range.levelCount;
+    uint32_t layer_end = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? image_state.array_layers : range.baseArrayLayer + range.layerCount;
+    assert(mip_end <= image_state.mip_levels && layer_end <= image_state.array_layers);
+    for (uint32_t mip = range.baseMipLevel; mip < mip_end; mip++) {
+        for (uint32_t layer = range.baseArrayLayer; layer < layer_end; layer++) {
+            image_state.subresources[mip * image_state.array_layers + layer] = state;
+        }
+    }
+}
+
+void SeResourceStateTracker::requireImage(VkImage image, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses) {
+    auto itr = m_images.find(image);
+    assert(itr != m_images.end());
+    VkImageSubresourceRange range = {itr->second.aspect_mask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    requireImage(image, range, layout, stages, accesses);
+}
+
+void SeResourceStateTracker::requireImage(VkImage image, const VkImageSubresourceRange &range, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses) {
+    auto itr = m_images.find(image);
+    assert(itr != m_images.end());
+    ImageState &image_state = itr->second;
+
+    Access required;
+    required.layout = layout;
+    required.stages = stages;
+    required.accesses = accesses;
+
+    uint32_t mip_end = range.levelCount == VK_REMAINING_MIP_LEVELS ? image_state.mip_levels : range.baseMipLevel + range.levelCount;
+    uint32_t layer_end = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? image_state.array_layers : range.baseArrayLayer + range.layerCount;
+    assert(mip_end <= image_state.mip_levels && layer_end <= image_state.array_layers);
+
+    for (uint32_t mip = range.baseMipLevel; mip < mip_end; mip++) {
+        // Consecutive layers in the same state share one barrier
+        uint32_t layer = range.baseArrayLayer;
+        while (layer < layer_end) {
+            ResourceState current = image_state.subresources[mip * image_state.array_layers + layer];
+            uint32_t run_end = layer + 1;
+            while (run_end < layer_end && image_state.subresources[mip * image_state.array_layers + run_end] == current) {
+                run_end++;
+            }
+
+            if (needsBarrier(current, required)) {
+                addImageBarrier(image, image_state, current, required, mip, layer, run_end - layer);
+            }
+            ResourceState next = nextState(current, required);
+            for (uint32_t i = layer; i < run_end; i++) {
+                image_state.subresources[mip * image_state.array_layers + i] = next;
+            }
+            layer = run_end;
+        }
+    }
+}
+
+void SeResourceStateTracker::addImageBarrier(VkImage image, const ImageState &image_state, const ResourceState &current, const Access &required, uint32_t mip_level, uint32_t base_layer, uint32_t layer_count) {
+    BarrierScope scope = barrierScope(current, required);
+
+    // Extend the previous barrier when it covers the mip level right above
+    if (!m_image_barriers.empty()) {
+        VkImageMemoryBarrier2 &last = m_image_barriers.back();
+        if (last.image == image && last.oldLayout == current.layout && last.newLayout == required.layout &&
+            last.srcStageMask == scope.src_stages && last.srcAccessMask == scope.src_accesses &&
+            last.dstStageMask == scope.dst_stages && last.dstAccessMask == scope.dst_accesses &&
+            last.subresourceRange.baseArrayLayer == base_layer && last.subresourceRange.layerCount == layer_count &&
+            last.subresourceRange.baseMipLevel + last.subresourceRange.levelCount == mip_level) {
+            last.subresourceRange.levelCount++;
+            return;
+        }
+    }
+
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = scope.src_stages;
+    barrier.srcAccessMask = scope.src_accesses;
+    barrier.dstStageMask = scope.dst_stages;
+    barrier.dstAccessMask = scope.dst_accesses;
+    barrier.oldLayout = current.layout;
+    barrier.newLayout = required.layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = {image_state.aspect_mask, mip_level, 1, base_layer, layer_count};
+    m_image_barriers.push_back(barrier);
+}
+
+VkImageLayout SeResourceStateTracker::imageLayout(VkImage image, uint32_t mip_level, uint32_t array_layer) const {
+    auto itr = m_images.find(image);
+    assert(itr != m_images.end());
+    return itr->second.subresources[mip_level * itr->second.array_layers + array_layer].layout;
+}
+
+#pragma endregion Images
+
+#pragma region Buffers
+void SeResourceStateTracker::registerBuffer(VkBuffer buffer, VkDeviceSize size) {
+    assert(buffer != VK_NULL_HANDLE && size > 0);
+    BufferState buffer_state;
+    buffer_state.size = size;
+    buffer_state.segments.push_back({0, size, ResourceState{}});
+    m_buffers[buffer] = std::move(buffer_state);
+}
+
+void SeResourceStateTracker::unregisterBuffer(VkBuffer buffer) {
+    m_buffers.erase(buffer);
+}
+
+void SeResourceStateTracker::splitBufferSegment(BufferState &buffer_state, VkDeviceSize offset) {
+    auto &segments = buffer_state.segments;
+    for (size_t i = 0; i < segments.size(); i++) {
+        BufferSegment &segment = segments[i];
+        if (offset > segment.offset && offset < segment.offset + segment.size) {
+            BufferSegment tail = segment;
+            tail.offset = offset;
+            tail.size = segment.offset + segment.size - offset;
+            segment.size = offset - segment.offset;
+            segments.insert(segments.begin() + i + 1, tail);
+            return;
+        }
+    }
+}
+
+void SeResourceStateTracker::requireBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses) {
+    auto itr = m_buffers.find(buffer);
+    assert(itr != m_buffers.end());
+    BufferState &buffer_state = itr->second;
+    if (size == VK_WHOLE_SIZE) {
+        size = buffer_state.size - offset;
+    }
+    assert(offset + size <= buffer_state.size);
+
+    Access required;
+    required.stages = stages;
+    required.accesses = accesses;
+
+    VkDeviceSize end = offset + size;
+    splitBufferSegment(buffer_state, offset);
+    splitBufferSegment(buffer_state, end);
+
+    for (auto &segment : buffer_state.segments) {
+        if (segment.offset < offset || segment.offset >= end) {
+            continue;
+        }
+        if (needsBarrier(segment.state, required)) {
+            BarrierScope scope = barrierScope(segment.state, required);
+            bool merged = false;
+            if (!m_buffer_barriers.empty()) {
+                VkBufferMemoryBarrier2 &last = m_buffer_barriers.back();
+                if (last.buffer == buffer && last.offset + last.size == segment.offset &&
+                    last.srcStageMask == scope.src_stages && last.srcAccessMask == scope.src_accesses &&
+                    last.dstStageMask == scope.dst_stages && last.dstAccessMask == scope.dst_accesses) {
+                    last.size += segment.size;
+                    merged = true;
+                }
+            }
+            if (!merged) {
+                VkBufferMemoryBarrier2 barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+                barrier.srcStageMask = scope.src_stages;
+                barrier.srcAccessMask = scope.src_accesses;
+                barrier.dstStageMask = scope.dst_stages;
+                barrier.dstAccessMask = scope.dst_accesses;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.buffer = buffer;
+                barrier.offset = segment.offset;
+                barrier.size = segment.size;
+                m_buffer_barriers.push_back(barrier);
+            }
+        }
+        segment.state = nextState(segment.state, required);
+    }
+
+    // Coalesce neighbours that ended up in the same state
+    auto &segments = buffer_state.segments;
+    for (size_t i = 1; i < segments.size();) {
+        if (segments[i - 1].state == segments[i].state) {
+            segments[i - 1].size += segments[i].size;
+            segments.erase(segments.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+#pragma endregion Buffers
+
+#pragma region Flush
+VkPipelineStageFlags SeResourceStateTracker::legacyStages(VkPipelineStageFlags2 stages) {
+    // The low 32 bits share their values with the legacy flags, the stages
+    // only synchronization2 has are lowered to the stages containing them
+    const VkPipelineStageFlags2 transfer_stages = VK_PIPELINE_STAGE_2_COPY_BIT |
+                                                  VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+                                                  VK_PIPELINE_STAGE_2_BLIT_BIT |
+                                                  VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    const VkPipelineStageFlags2 vertex_input_stages = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT |
+                                                      VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+    VkPipelineStageFlags legacy_stages = static_cast<VkPipelineStageFlags>(stages & 0xFFFFFFFFull);
+    if (stages & transfer_stages) {
+        legacy_stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    if (stages & vertex_input_stages) {
+        legacy_stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+    if (stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) {
+        legacy_stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+                         VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+    }
+    assert((stages & ~(0xFFFFFFFFull | transfer_stages | vertex_input_stages | VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT)) == 0);
+    return legacy_stages;
+}
+
+VkAccessFlags SeResourceStateTracker::legacyAccesses(VkAccessFlags2 accesses) {
+    // Same for accesses, the split shader accesses fold into the generic ones
+    const VkAccessFlags2 shader_reads = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT |
+                                        VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+    VkAccessFlags legacy_accesses = static_cast<VkAccessFlags>(accesses & 0xFFFFFFFFull);
+    if (accesses & shader_reads) {
+        legacy_accesses |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if (accesses & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) {
+        legacy_accesses |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+    assert((accesses & ~(0xFFFFFFFFull | shader_reads | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)) == 0);
+    return legacy_accesses;
+}
+
+bool SeResourceStateTracker::hasPendingBarriers() const {
+    return !m_image_barriers.empty() || !m_buffer_barriers.empty();
+}
+
+void SeResourceStateTracker::flush(VkCommandBuffer command_buffer) {
+    if (!hasPendingBarriers()) {
+        return;
+    }
+    m_emitted_barrier_count += m_image_barriers.size() + m_buffer_barriers.size();
+
+    if (m_vkCmdPipelineBarrier2 != nullptr) {
+        VkDependencyInfo dependency_info{};
+        dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(m_image_barriers.size());
+        dependency_info.pImageMemoryBarriers = m_image_barriers.data();
+        dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(m_buffer_barriers.size());
+        dependency_info.pBufferMemoryBarriers = m_buffer_barriers.data();
+        m_vkCmdPipelineBarrier2(command_buffer, &dependency_info);
+    } else {
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+        for (const auto &barrier2 : m_image_barriers) {
+            src_stages |= legacyStages(barrier2.srcStageMask);
+            dst_stages |= legacyStages(barrier2.dstStageMask);
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = legacyAccesses(barrier2.srcAccessMask);
+            barrier.dstAccessMask = legacyAccesses(barrier2.dstAccessMask);
+            barrier.oldLayout = barrier2.oldLayout;
+            barrier.newLayout = barrier2.newLayout;
+            barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+            barrier.image = barrier2.image;
+            barrier.subresourceRange = barrier2.subresourceRange;
+            image_barriers.push_back(barrier);
+        }
+        for (const auto &barrier2 : m_buffer_barriers) {
+            src_stages |= legacyStages(barrier2.srcStageMask);
+            dst_stages |= legacyStages(barrier2.dstStageMask);
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = legacyAccesses(barrier2.srcAccessMask);
+            barrier.dstAccessMask = legacyAccesses(barrier2.dstAccessMask);
+            barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+            barrier.buffer = barrier2.buffer;
+            barrier.offset = barrier2.offset;
+            barrier.size = barrier2.size;
+            buffer_barriers.push_back(barrier);
+        }
+        if (src_stages == 0) {
+            src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        }
+        if (dst_stages == 0) {
+            dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+        vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, nullptr,
+                             static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                             static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+    }
+
+    m_image_barriers.clear();
+    m_buffer_barriers.clear();
+}
+
+uint64_t SeResourceStateTracker::emittedBarrierCount() const {
+    return m_emitted_barrier_count;
+}
+
+#pragma endregion Flush
@@ -0,0 +1,103 @@
+#ifndef SE_RESOURCE_STATE_TRACKER_H
+#define SE_RESOURCE_STATE_TRACKER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Tracks layout, last write and readers of every image subresource and buffer
+// range, and turns declared uses into the minimal set of barriers. Reads in the
+// same layout need no barrier once the last write is visible to their stage
+// and access; everything else gets exactly one barrier per distinct previous
+// state. All barriers collected between two flush() calls are emitted with a
+// single vkCmdPipelineBarrier2, or with one vkCmdPipelineBarrier when
+// synchronization2 is not available.
+class SeResourceStateTracker {
+  public:
+    struct ResourceState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // The last write or layout transition, kept until the next one
+        VkPipelineStageFlags2 write_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 write_accesses = VK_ACCESS_2_NONE;
+        // Reads since then, the last write is visible to all of them
+        VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 read_accesses = VK_ACCESS_2_NONE;
+
+        bool operator==(const ResourceState &other) const {
+            return layout == other.layout && write_stages == other.write_stages && write_accesses == other.write_accesses &&
+                   read_stages == other.read_stages && read_accesses == other.read_accesses;
+        }
+    };
+
+    void init(PFN_vkCmdPipelineBarrier2KHR cmd_pipeline_barrier2);
+    void clear();
+
+    void registerImage(VkImage image, VkImageAspectFlags aspect_mask, uint32_t mip_levels, uint32_t array_layers, VkImageLayout initial_layout);
+    void unregisterImage(VkImage image);
+    void resetImage(VkImage image, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses);
+    void resetImage(VkImage image, const VkImageSubresourceRange &range, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses);
+    void requireImage(VkImage image, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses);
+    void requireImage(VkImage image, const VkImageSubresourceRange &range, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses);
+    VkImageLayout imageLayout(VkImage image, uint32_t mip_level, uint32_t array_layer) const;
+
+    void registerBuffer(VkBuffer buffer, VkDeviceSize size);
+    void unregisterBuffer(VkBuffer buffer);
+    void requireBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags2 stages, VkAccessFlags2 accesses);
+
+    bool hasPendingBarriers() const;
+    void flush(VkCommandBuffer command_buffer);
+    uint64_t emittedBarrierCount() const;
+
+  private:
+    struct ImageState {
+        VkImageAspectFlags aspect_mask = 0;
+        uint32_t mip_levels = 1;
+        uint32_t array_layers = 1;
+        std::vector<ResourceState> subresources;
+    };
+
+    struct BufferSegment {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        ResourceState state;
+    };
+
+    struct BufferState {
+        VkDeviceSize size = 0;
+        std::vector<BufferSegment> segments;
+    };
+
+    struct Access {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 accesses = VK_ACCESS_2_NONE;
+    };
+
+    struct BarrierScope {
+        VkPipelineStageFlags2 src_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 src_accesses = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 dst_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 dst_accesses = VK_ACCESS_2_NONE;
+    };
+
+    static bool needsBarrier(const ResourceState &current, const Access &required);
+    static BarrierScope barrierScope(const ResourceState &current, const Access &required);
+    static ResourceState nextState(const ResourceState &current, const Access &required);
+    static VkAccessFlags2 writeAccesses(VkAccessFlags2 accesses);
+    static VkPipelineStageFlags legacyStages(VkPipelineStageFlags2 stages);
+    static VkAccessFlags legacyAccesses(VkAccessFlags2 accesses);
+    void addImageBarrier(VkImage image, const ImageState &image_state, const ResourceState &current, const Access &required, uint32_t mip_level, uint32_t base_layer, uint32_t layer_count);
+    void splitBufferSegment(BufferState &buffer_state, VkDeviceSize offset);
+
+    PFN_vkCmdPipelineBarrier2KHR m_vkCmdPipelineBarrier2 = nullptr;
+
+    std::unordered_map<VkImage, ImageState> m_images;
+    std::unordered_map<VkBuffer, BufferState> m_buffers;
+
+    std::vector<VkImageMemoryBarrier2> m_image_barriers;
+    std::vector<VkBufferMemoryBarrier2> m_buffer_barriers;
+    uint64_t m_emitted_barrier_count = 0;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "SeSwapChainTuner.h"
+#include <QDebug>
+#include <QSettings>
+#include <algorithm>
+
+#pragma region Settings
+void SeSwapChainTuner::setDevice(const VkPhysicalDevice device) {
+    assert(device != VK_NULL_HANDLE);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    m_device_key = QString("%1-%2-%3").arg(properties.vendorID, 0, 16).arg(properties.deviceID, 0, 16).arg(properties.driverVersion);
+
+    QSettings settings("IOSurfer", "ShaderEditor");
+    m_image_count_override = settings.value("SwapChain/ImageCountOverride", 0).toUInt();
+}
+
+QString SeSwapChainTuner::settingsKey(VkPresentModeKHR present_mode) const {
+    return QString("SwapChain/%1/PresentMode%2/ImageCount").arg(m_device_key).arg(static_cast<int>(present_mode));
+}
+
+void SeSwapChainTuner::setImageCountOverride(uint32_t image_count) {
+    m_image_count_override = image_count;
+    QSettings settings("IOSurfer", "ShaderEditor");
+    settings.setValue("SwapChain/ImageCountOverride", image_count);
+}
+
+uint32_t SeSwapChainTuner::imageCountOverride() const {
+    return m_image_count_override;
+}
+
+#pragma endregion Settings
+
+#pragma region Image count
+uint32_t SeSwapChainTuner::clampImageCount(const VkSurfaceCapabilitiesKHR &capabilities, uint32_t image_count) {
+    image_count = std::max(image_count, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0) {
+        image_count = std::min(image_count, capabilities.maxImageCount);
+    }
+    return image_count;
+}
+
+uint32_t SeSwapChainTuner::chooseImageCount(const VkSurfaceCapabilitiesKHR &capabilities, VkPresentModeKHR present_mode) {
+    if (m_sweep_requested) {
+        m_sweep_requested = false;
+        m_sweeping = true;
+        m_sweep_present_mode = present_mode;
+        m_candidates.clear();
+        m_samples.clear();
+        uint32_t max_count = capabilities.minImageCount + MAX_EXTRA_IMAGES;
+        for (uint32_t count = capabilities.minImageCount; count <= max_count; count++) {
+            if (clampImageCount(capabilities, count) == count) {
+                m_candidates.push_back(count);
+            }
+        }
+        m_candidate_index = 0;
+        m_frame_index = 0;
+        qDebug() << "Swap chain sweep over" << m_candidates.size() << "image counts started";
+    }
+
+    if (m_sweeping) {
+        return m_candidates[m_candidate_index];
+    }
+
+    if (m_image_count_override > 0) {
+        return clampImageCount(capabilities, m_image_count_override);
+    }
+
+    QSettings settings("IOSurfer", "ShaderEditor");
+    uint32_t tuned_count = settings.value(settingsKey(present_mode), 0).toUInt();
+    if (tuned_count > 0) {
+        return clampImageCount(capabilities, tuned_count);
+    }
+
+    return clampImageCount(capabilities, capabilities.minImageCount + 1);
+}
+
+#pragma endregion Image count
+
+#pragma region Sweep
+void SeSwapChainTuner::startSweep() {
+    m_sweep_requested = true;
+}
+
+bool SeSwapChainTuner::isSweeping() const {
+    return m_sweep_requested || m_sweeping;
+}
+
+bool SeSwapChainTuner::recordFrame(double latency_ms) {
+    if (!m_sweeping) {
+        return false;
+    }
+
+    m_frame_index++;
+    if (m_frame_index == WARMUP_FRAMES) {
+        m_measure_start = Clock::now();
+    }
+    if (m_frame_index < WARMUP_FRAMES + MEASURED_FRAMES) {
+        return false;
+    }
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - m_measure_start).count();
+    Sample sample;
+    sample.image_count = m_candidates[m_candidate_index];
+    sample.frame_time_ms = elapsed_ms / MEASURED_FRAMES;
+    sample.frames_per_second = elapsed_ms > 0.0 ? MEASURED_FRAMES * 1000.0 / elapsed_ms : 0.0;
+    sample.latency_ms = latency_ms;
+    m_samples.push_back(sample);
+    qDebug() << "Swap chain images" << sample.image_count << ":"
+             << sample.frame_time_ms << "ms/frame,"
+             << sample.frames_per_second << "fps,"
+             << sample.latency_ms << "ms latency";
+
+    m_frame_index = 0;
+    m_candidate_index++;
+    if (m_candidate_index == m_candidates.size()) {
+        finishSweep();
+    }
+    // The swap chain has to be recreated for the next candidate or the result
+    return true;
+}
+
+void SeSwapChainTuner::finishSweep() {
+    m_sweeping = false;
+    if (m_samples.empty()) {
+        return;
+    }
+
+    double best_throughput = 0.0;
+    for (const auto &sample : m_samples) {
+        best_throughput = std::max(best_throughput, sample.frames_per_second);
+    }
+
+    // Fewest images first, so without latency data the smallest count that
+    // keeps the GPU fed wins
+    const Sample *best = nullptr;
+    for (const auto &sample : m_samples) {
+        if (sample.frames_per_second < best_throughput * THROUGHPUT_TOLERANCE) {
+            continue;
+        }
+        if (best == nullptr || (sample.latency_ms > 0.0 && sample.latency_ms < best->latency_ms)) {
+            best = &sample;
+        }
+    }
+    assert(best != nullptr);
+
+    QSettings settings("IOSurfer", "ShaderEditor");
+    settings.setValue(settingsKey(m_sweep_present_mode), best->image_count);
+    qDebug() << "Swap chain sweep finished, using" << best->image_count << "images";
+}
+
+const std::vector<SeSwapChainTuner::Sample> &SeSwapChainTuner::samples() const {
+    return m_samples;
+}
+
+#pragma endregion Sweep
@@ -0,0 +1,60 @@
+#ifndef SE_SWAP_CHAIN_TUNER_H
+#define SE_SWAP_CHAIN_TUNER_H
+
+#include <QString>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Picks the swap chain image count. A fixed count can be forced through the
+// settings, otherwise the result of a previous sweep for the same device and
+// present mode is used. A sweep renders a fixed number of frames with every
+// legal image count, records frame time, throughput and latency for each and
+// persists the count with the lowest latency that keeps full throughput.
+class SeSwapChainTuner {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample {
+        uint32_t image_count = 0;
+        double frame_time_ms = 0.0;
+        double frames_per_second = 0.0;
+        double latency_ms = 0.0;
+    };
+
+    void setDevice(const VkPhysicalDevice device);
+
+    uint32_t chooseImageCount(const VkSurfaceCapabilitiesKHR &capabilities, VkPresentModeKHR present_mode);
+    void setImageCountOverride(uint32_t image_count);
+    uint32_t imageCountOverride() const;
+
+    void startSweep();
+    bool isSweeping() const;
+    bool recordFrame(double latency_ms);
+    const std::vector<Sample> &samples() const;
+
+  private:
+    static constexpr uint32_t WARMUP_FRAMES = 30;
+    static constexpr uint32_t MEASURED_FRAMES = 120;
+    static constexpr uint32_t MAX_EXTRA_IMAGES = 3;
+    static constexpr double THROUGHPUT_TOLERANCE = 0.95;
+
+    QString settingsKey(VkPresentModeKHR present_mode) const;
+    static uint32_t clampImageCount(const VkSurfaceCapabilitiesKHR &capabilities, uint32_t image_count);
+    void finishSweep();
+
+    QString m_device_key;
+    uint32_t m_image_count_override = 0;
+
+    bool m_sweep_requested = false;
+    bool m_sweeping = false;
+    VkPresentModeKHR m_sweep_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    std::vector<uint32_t> m_candidates;
+    size_t m_candidate_index = 0;
+    uint32_t m_frame_index = 0;
+    Clock::time_point m_measure_start;
+    std::vector<Sample> m_samples;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "SeTextureCache.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+#pragma region Init and cleanup
+SeTextureCache::SeTextureCache() {
+}
+
+SeTextureCache::~SeTextureCache() {
+}
+
+void SeTextureCache::setDirectory(const QString &directory) {
+    // An empty directory turns the cache off
+    m_directory = directory;
+    if (!m_directory.isEmpty() && !QDir().mkpath(m_directory)) {
+        qDebug() << "Failed to create texture cache directory" << m_directory;
+        m_directory.clear();
+    }
+}
+
+bool SeTextureCache::isEnabled() const {
+    return !m_directory.isEmpty();
+}
+
+QString SeTextureCache::filePath(const QByteArray &key) const {
+    return m_directory + "/" + QString::fromLatin1(key.toHex()) + ".setex";
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Layout
+QByteArray SeTextureCache::key(const QByteArray &source, VkFormat format) {
+    // The same image uploaded as sRGB and as linear data are two entries
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(source);
+    uint32_t format_value = static_cast<uint32_t>(format);
+    hash.addData(QByteArrayView(reinterpret_cast<const char *>(&format_value), sizeof(format_value)));
+    return hash.result();
+}
+
+std::vector<SeTextureCache::Level> SeTextureCache::levelLayout(VkExtent2D extent, uint32_t level_count, uint32_t texel_size, VkDeviceSize &data_size) {
+    std::vector<Level> levels(level_count);
+    data_size = 0;
+    for (uint32_t i = 0; i < level_count; i++) {
+        VkDeviceSize width = std::max(1u, extent.width >> i);
+        VkDeviceSize height = std::max(1u, extent.height >> i);
+        data_size = (data_size + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+        levels[i].offset = data_size;
+        levels[i].size = width * height * texel_size;
+        data_size += levels[i].size;
+    }
+    return levels;
+}
+
+#pragma endregion Layout
+
+#pragma region Files
+SeTextureCache::Entry SeTextureCache::open(const QByteArray &key) const {
+    Entry entry;
+    if (!isEnabled()) {
+        return entry;
+    }
+    auto file = std::make_unique<QFile>(filePath(key));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return entry;
+    }
+    qint64 file_size = file->size();
+    const uint8_t *data = file->map(0, file_size);
+    if (data == nullptr || file_size < static_cast<qint64>(sizeof(FileHeader))) {
+        qDebug() << "Failed to map texture cache entry" << file->fileName();
+        return entry;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    qint64 index_end = sizeof(FileHeader) + static_cast<qint64>(header.level_count) * sizeof(LevelIndex);
+    if (std::memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 || header.level_count == 0 || header.level_count > 32 || index_end > file_size) {
+        qDebug() << "Ignoring invalid texture cache entry" << file->fileName();
+        return entry;
+    }
+    entry.levels.resize(header.level_count);
+    for (uint32_t i = 0; i < header.level_count; i++) {
+        LevelIndex index;
+        std::memcpy(&index, data + sizeof(FileHeader) + i * sizeof(LevelIndex), sizeof(index));
+        if (index.offset % LEVEL_ALIGNMENT != 0 || index.offset + index.size > static_cast<uint64_t>(file_size)) {
+            qDebug() << "Ignoring truncated texture cache entry" << file->fileName();
+            return Entry{};
+        }
+        entry.levels[i] = {index.offset, index.size};
+    }
+    entry.format = static_cast<VkFormat>(header.format);
+    entry.extent = {header.width, header.height};
+    entry.data = data;
+    entry.file = std::move(file);
+    return entry;
+}
+
+bool SeTextureCache::write(const QByteArray &key, VkFormat format, VkExtent2D extent, const std::vector<Level> &levels, const void *data, VkDeviceSize data_size) const {
+    if (!isEnabled()) {
+        return false;
+    }
+    FileHeader header{};
+    std::memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+    header.format = static_cast<uint32_t>(format);
+    header.width = extent.width;
+    header.height = extent.height;
+    header.level_count = static_cast<uint32_t>(levels.size());
+
+    // Level offsets in the layout start at the level data, which follows
+    // the index at the next aligned position
+    uint64_t data_start = sizeof(FileHeader) + levels.size() * sizeof(LevelIndex);
+    data_start = (data_start + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+    std::vector<LevelIndex> index(levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        index[i] = {data_start + levels[i].offset, levels[i].size};
+    }
+
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to create texture cache entry" << file.fileName();
+        return false;
+    }
+    QByteArray padding(static_cast<qsizetype>(data_start - sizeof(FileHeader) - index.size() * sizeof(LevelIndex)), '\0');
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(index.data()), static_cast<qint64>(index.size() * sizeof(LevelIndex)));
+    file.write(padding);
+    file.write(static_cast<const char *>(data), static_cast<qint64>(data_size));
+    if (!file.commit()) {
+        qDebug() << "Failed to write texture cache entry" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+#pragma endregion Files
@@ -0,0 +1,79 @@
+#ifndef SE_TEXTURE_CACHE_H
+#define SE_TEXTURE_CACHE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Keeps processed textures on disk so that later launches skip decoding and
+// mip generation. Every file is named after a hash of the source file's
+// bytes and the target format, and holds a KTX2 style header with the exact
+// VkFormat, the level index and the texels of the full mip chain, largest
+// level first and every level four byte aligned. Opening an entry memory
+// maps the file, so the upload ring copies straight from the page cache
+// into staging memory. Files are written through a temporary file that is
+// renamed once complete, so a crash never leaves a torn entry behind. Every
+// method is const and safe to call from the decode threads.
+class SeTextureCache {
+  public:
+    struct Level {
+        // From the start of the file, or of the level data in a layout
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
+    struct Entry {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {0, 0};
+        std::vector<Level> levels;
+        // Mapped contents of the file, valid while the entry lives
+        const uint8_t *data = nullptr;
+        std::unique_ptr<QFile> file;
+
+        bool isValid() const {
+            return data != nullptr;
+        }
+    };
+
+    SeTextureCache();
+    ~SeTextureCache();
+
+    void setDirectory(const QString &directory);
+    bool isEnabled() const;
+
+    static QByteArray key(const QByteArray &source, VkFormat format);
+    static std::vector<Level> levelLayout(VkExtent2D extent, uint32_t level_count, uint32_t texel_size, VkDeviceSize &data_size);
+
+    Entry open(const QByteArray &key) const;
+    bool write(const QByteArray &key, VkFormat format, VkExtent2D extent, const std::vector<Level> &levels, const void *data, VkDeviceSize data_size) const;
+
+  private:
+    static constexpr uint8_t IDENTIFIER[12] = {0xAB, 'S', 'E', 'T', ' ', '1', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    static constexpr VkDeviceSize LEVEL_ALIGNMENT = 4;
+
+    struct FileHeader {
+        uint8_t identifier[12];
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t level_count;
+    };
+
+    struct LevelIndex {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    SeTextureCache(const SeTextureCache &) = delete;
+    SeTextureCache &operator=(const SeTextureCache &) = delete;
+
+    QString filePath(const QByteArray &key) const;
+
+    QString m_directory;
+};
+
+#endif
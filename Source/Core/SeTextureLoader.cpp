@@ -0,0 +1,611 @@
+#include "SeTextureLoader.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+
+#pragma region Init and cleanup
+SeTextureLoader::SeTextureLoader() {
+}
+
+SeTextureLoader::~SeTextureLoader() {
+    cleanup();
+}
+
+void SeTextureLoader::init(VkDevice device, VkPhysicalDevice physical_device, SeMemoryAllocator *memory_allocator, SeUploadRing *upload_ring, SeResidencyManager *residency_manager,
+                           SeResourceStateTracker *state_tracker, SeDeletionQueue *deletion_queue, const QString &cache_directory, uint32_t thread_count) {
+    assert(device != VK_NULL_HANDLE && memory_allocator != nullptr && upload_ring != nullptr && residency_manager != nullptr && state_tracker != nullptr &&
+           deletion_queue != nullptr);
+    cleanup();
+
+    if (thread_count == 0) {
+        // Decoding is the slow part, leave one core to the render thread
+        thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    m_device = device;
+    m_physical_device = physical_device;
+    m_memory_allocator = memory_allocator;
+    m_upload_ring = upload_ring;
+    m_residency_manager = residency_manager;
+    m_state_tracker = state_tracker;
+    m_deletion_queue = deletion_queue;
+    m_frame_number = 0;
+    m_cache.setDirectory(cache_directory);
+    createSampler();
+
+    m_stopping = false;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        m_threads.emplace_back(&SeTextureLoader::workerThread, this);
+    }
+    qDebug() << "Texture loader started with" << thread_count << "decode threads";
+}
+
+void SeTextureLoader::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    {
+        // Queued cache writes are still finished. Read backs whose frame
+        // was never seen complete may hold garbage after a device loss
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+    }
+    m_work_condition.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    m_results.clear();
+    for (auto &readback : m_finished_writes) {
+        destroyReadback(readback);
+    }
+    for (auto &readback : m_readbacks) {
+        destroyReadback(readback);
+    }
+    m_finished_writes.clear();
+    m_readbacks.clear();
+
+    // The caller has waited for the device to become idle
+    for (auto &texture : m_textures) {
+        if (texture.residency != SeResidencyManager::INVALID_ENTRY) {
+            m_residency_manager->remove(texture.residency);
+        }
+        if (texture.image != VK_NULL_HANDLE) {
+            m_state_tracker->unregisterImage(texture.image);
+            vkDestroyImageView(m_device, texture.view, nullptr);
+            m_memory_allocator->destroyImage(texture.image, texture.allocation);
+        }
+    }
+    m_textures.clear();
+    m_free_handles.clear();
+    m_revived.clear();
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    m_sampler = VK_NULL_HANDLE;
+    m_deletion_queue = nullptr;
+    m_upload_ring = nullptr;
+    m_residency_manager = nullptr;
+    m_state_tracker = nullptr;
+    m_memory_allocator = nullptr;
+    m_physical_device = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+    qDebug() << "Texture loader stopped";
+}
+
+void SeTextureLoader::createSampler() {
+    // Shadertoy defaults: trilinear filtering and repeating coordinates
+    VkSamplerCreateInfo sampler_info{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+
+    VkResult result;
+    result = vkCreateSampler(m_device, &sampler_info, nullptr, &m_sampler);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create texture sampler!";
+    }
+    assert(result == VK_SUCCESS);
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Decoding
+SeTextureLoader::TextureHandle SeTextureLoader::load(const QString &path, bool srgb) {
+    assert(m_device != VK_NULL_HANDLE);
+    VkFormat format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    QDateTime modified = QFileInfo(path).lastModified();
+    TextureHandle handle = reviveTexture(path, format, modified);
+    if (handle != INVALID_TEXTURE) {
+        return handle;
+    }
+    if (!m_free_handles.empty()) {
+        handle = m_free_handles.back();
+        m_free_handles.pop_back();
+    } else {
+        handle = static_cast<TextureHandle>(m_textures.size());
+        m_textures.emplace_back();
+    }
+
+    Texture &texture = m_textures[handle];
+    texture = Texture{};
+    texture.state = State::DECODING;
+    texture.path = path;
+    texture.modified = modified;
+    texture.format = format;
+    texture.request_time = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back({handle, path, texture.format});
+    }
+    m_work_condition.notify_one();
+    return handle;
+}
+
+void SeTextureLoader::workerThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_work_condition.wait(lock, [this] { return m_stopping || !m_jobs.empty() || !m_write_jobs.empty(); });
+        if (!m_jobs.empty()) {
+            DecodeJob job = m_jobs.front();
+            m_jobs.pop_front();
+            lock.unlock();
+
+            DecodeResult result;
+            decode(result, job);
+
+            lock.lock();
+            m_results.push_back(std::move(result));
+        } else if (!m_write_jobs.empty()) {
+            Readback readback = std::move(m_write_jobs.front());
+            m_write_jobs.pop_front();
+            lock.unlock();
+
+            if (m_cache.write(readback.cache_key, readback.format, readback.extent, readback.levels, readback.allocation.mapped, readback.data_size)) {
+                qDebug() << "Texture" << readback.path << "added to the cache";
+            }
+
+            lock.lock();
+            m_finished_writes.push_back(std::move(readback));
+        } else {
+            // Stopping with nothing left to write
+            return;
+        }
+    }
+}
+
+void SeTextureLoader::decode(DecodeResult &result, const DecodeJob &job) const {
+    auto start = std::chrono::steady_clock::now();
+    result.texture = job.texture;
+    QByteArray source;
+    QFile file(job.path);
+    if (file.open(QIODevice::ReadOnly)) {
+        source = file.readAll();
+    }
+
+    if (!source.isEmpty() && m_cache.isEnabled()) {
+        result.cache_key = SeTextureCache::key(source, job.format);
+        result.cached = m_cache.open(result.cache_key);
+        if (result.cached.isValid()) {
+            // Only a full chain of tightly packed levels is taken as is
+            VkDeviceSize data_size = 0;
+            auto layout = SeTextureCache::levelLayout(result.cached.extent, static_cast<uint32_t>(result.cached.levels.size()), TEXEL_SIZE, data_size);
+            bool matches = result.cached.format == job.format;
+            for (size_t i = 0; matches && i < layout.size(); i++) {
+                matches = result.cached.levels[i].size == layout[i].size;
+            }
+            if (!matches) {
+                qDebug() << "Texture cache entry of" << job.path << "does not match, decoding again";
+                result.cached = SeTextureCache::Entry{};
+            }
+        }
+    }
+
+    if (!result.cached.isValid() && !source.isEmpty()) {
+        // QImage is reentrant, so every worker decodes into its own copy.
+        // RGBA8888 rows of four byte texels are tightly packed
+        result.pixels = QImage::fromData(source);
+        if (!result.pixels.isNull()) {
+            result.pixels.convertTo(QImage::Format_RGBA8888);
+        }
+    }
+    result.decode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+#pragma endregion Decoding
+
+#pragma region Uploads
+void SeTextureLoader::update(uint64_t frame_number, uint64_t completed_frame_number) {
+    m_frame_number = frame_number;
+    std::vector<DecodeResult> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results.swap(m_results);
+    }
+
+    for (auto &decoded : results) {
+        Texture &texture = m_textures[decoded.texture];
+        texture.decode_ms = decoded.decode_ms;
+        if (texture.released) {
+            destroyTexture(texture, frame_number);
+            m_free_handles.push_back(decoded.texture);
+            continue;
+        }
+        if (decoded.pixels.isNull() && !decoded.cached.isValid()) {
+            qDebug() << "Failed to decode texture" << texture.path;
+            texture.state = State::FAILED;
+            continue;
+        }
+        texture.pixels = std::move(decoded.pixels);
+        texture.cached = std::move(decoded.cached);
+        texture.cache_key = decoded.cache_key;
+        createTexture(texture);
+    }
+
+    for (TextureHandle handle = 0; handle < m_textures.size(); handle++) {
+        Texture &texture = m_textures[handle];
+        if (texture.state != State::UPLOADING) {
+            continue;
+        }
+        // Uploads are staged in order, so the last one covers every level
+        if (m_upload_ring->isStaged(texture.upload)) {
+            texture.pixels = QImage();
+            texture.cached = SeTextureCache::Entry{};
+        }
+        // A texture dropped mid upload goes once the ring is done with it,
+        // after the frame that may have recorded its acquire barrier
+        if (texture.released && m_upload_ring->isComplete(texture.upload)) {
+            destroyTexture(texture, frame_number);
+            m_free_handles.push_back(handle);
+        }
+    }
+
+    // Chains read back by completed frames are ready to be written
+    std::vector<Readback> finished_writes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto completed = std::stable_partition(m_readbacks.begin(), m_readbacks.end(), [completed_frame_number](const Readback &readback) {
+            return readback.frame_number > completed_frame_number;
+        });
+        for (auto itr = completed; itr != m_readbacks.end(); itr++) {
+            m_write_jobs.push_back(std::move(*itr));
+        }
+        m_readbacks.erase(completed, m_readbacks.end());
+        finished_writes.swap(m_finished_writes);
+    }
+    m_work_condition.notify_all();
+    for (auto &readback : finished_writes) {
+        destroyReadback(readback);
+    }
+}
+
+void SeTextureLoader::createTexture(Texture &texture) {
+    texture.mip_levels = 1;
+    if (texture.cached.isValid()) {
+        texture.extent = texture.cached.extent;
+        texture.mip_levels = static_cast<uint32_t>(texture.cached.levels.size());
+    } else {
+        texture.extent = {static_cast<uint32_t>(texture.pixels.width()), static_cast<uint32_t>(texture.pixels.height())};
+    }
+    if (!texture.cached.isValid() && supportsMipBlits(texture.format)) {
+        uint32_t size = std::max(texture.extent.width, texture.extent.height);
+        while (size > 1) {
+            size >>= 1;
+            texture.mip_levels++;
+        }
+    }
+
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = texture.format;
+    image_info.extent = {texture.extent.width, texture.extent.height, 1};
+    image_info.mipLevels = texture.mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult result;
+    result = m_memory_allocator->createImage(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.allocation);
+    assert(result == VK_SUCCESS);
+
+    VkImageViewCreateInfo view_info{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = texture.image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = texture.format;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.baseMipLevel = 0;
+    view_info.subresourceRange.levelCount = texture.mip_levels;
+    view_info.subresourceRange.baseArrayLayer = 0;
+    view_info.subresourceRange.layerCount = 1;
+    result = vkCreateImageView(m_device, &view_info, nullptr, &texture.view);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create texture view for" << texture.path;
+    }
+    assert(result == VK_SUCCESS);
+
+    if (texture.cached.isValid()) {
+        uploadCachedLevels(texture);
+        return;
+    }
+
+    // The base level lands ready to be blitted or copied from, a texture
+    // with nothing left to do goes straight to the fragment shader
+    texture.write_cache = m_cache.isEnabled() && !texture.cache_key.isEmpty();
+    texture.transfer_pass = texture.mip_levels > 1 || texture.write_cache;
+    SeUploadRing::ImageRegion region;
+    region.extent = image_info.extent;
+    if (texture.transfer_pass) {
+        texture.upload = m_upload_ring->uploadImage(texture.image, region, texture.pixels.constBits(), static_cast<VkDeviceSize>(texture.pixels.sizeInBytes()),
+                                                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    } else {
+        texture.upload = m_upload_ring->uploadImage(texture.image, region, texture.pixels.constBits(), static_cast<VkDeviceSize>(texture.pixels.sizeInBytes()),
+                                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+    texture.state = State::UPLOADING;
+}
+
+void SeTextureLoader::uploadCachedLevels(Texture &texture) {
+    // Every level comes from the mapped file, no transfer pass follows
+    for (uint32_t level = 0; level < texture.mip_levels; level++) {
+        const SeTextureCache::Level &cached_level = texture.cached.levels[level];
+        SeUploadRing::ImageRegion region;
+        region.mip_level = level;
+        region.extent = {std::max(1u, texture.extent.width >> level), std::max(1u, texture.extent.height >> level), 1};
+        texture.upload = m_upload_ring->uploadImage(texture.image, region, texture.cached.data + cached_level.offset, cached_level.size, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+    texture.state = State::UPLOADING;
+}
+
+void SeTextureLoader::release(TextureHandle handle, uint64_t last_use_frame_number) {
+    assert(handle < m_textures.size() && m_textures[handle].state != State::FREE);
+    Texture &texture = m_textures[handle];
+    if (texture.state == State::DECODING || texture.state == State::UPLOADING) {
+        // Finished by update() once the worker or the ring lets go of it
+        texture.released = true;
+        return;
+    }
+    m_revived.erase(std::remove(m_revived.begin(), m_revived.end(), handle), m_revived.end());
+    if (texture.state == State::READY) {
+        // Kept until the memory is needed or the file is loaded again
+        texture.state = State::CACHED;
+        texture.last_use_frame_number = last_use_frame_number;
+        texture.residency = m_residency_manager->add(texture.allocation, [this, handle]() { evictTexture(handle); });
+        return;
+    }
+    destroyTexture(texture, last_use_frame_number);
+    m_free_handles.push_back(handle);
+}
+
+SeTextureLoader::TextureHandle SeTextureLoader::reviveTexture(const QString &path, VkFormat format, const QDateTime &modified) {
+    for (TextureHandle handle = 0; handle < m_textures.size(); handle++) {
+        Texture &texture = m_textures[handle];
+        if (texture.state != State::CACHED || texture.path != path || texture.format != format) {
+            continue;
+        }
+        m_residency_manager->remove(texture.residency);
+        texture.residency = SeResidencyManager::INVALID_ENTRY;
+        if (texture.modified != modified) {
+            // The file changed since, the old contents are of no use
+            destroyTexture(texture, texture.last_use_frame_number);
+            m_free_handles.push_back(handle);
+            continue;
+        }
+        texture.state = State::READY;
+        m_revived.push_back(handle);
+        qDebug() << "Texture" << path << "still resident, skipping the upload";
+        return handle;
+    }
+    return INVALID_TEXTURE;
+}
+
+void SeTextureLoader::evictTexture(TextureHandle handle) {
+    // The residency manager has already dropped its entry
+    Texture &texture = m_textures[handle];
+    assert(texture.state == State::CACHED);
+    texture.residency = SeResidencyManager::INVALID_ENTRY;
+    destroyTexture(texture, texture.last_use_frame_number);
+    m_free_handles.push_back(handle);
+    // Only memory that is actually freed relieves the heap, an idle window
+    // would not collect its queue before its next frame
+    m_deletion_queue->collectCompleted();
+}
+
+void SeTextureLoader::destroyTexture(Texture &texture, uint64_t last_use_frame_number) {
+    if (texture.image != VK_NULL_HANDLE) {
+        // Later barriers can only come from a new image with a new state
+        m_state_tracker->unregisterImage(texture.image);
+        VkDevice device = m_device;
+        SeMemoryAllocator *memory_allocator = m_memory_allocator;
+        VkImage image = texture.image;
+        VkImageView view = texture.view;
+        SeMemoryAllocator::Allocation allocation = texture.allocation;
+        // Frames retired to the queue never go backwards
+        m_deletion_queue->retire(std::max(last_use_frame_number, m_frame_number), [device, memory_allocator, image, view, allocation]() mutable {
+            vkDestroyImageView(device, view, nullptr);
+            memory_allocator->destroyImage(image, allocation);
+        });
+    }
+    texture = Texture{};
+}
+
+#pragma endregion Uploads
+
+#pragma region Mip generation
+bool SeTextureLoader::supportsMipBlits(VkFormat format) const {
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(m_physical_device, format, &format_properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (format_properties.optimalTilingFeatures & required) == required;
+}
+
+std::vector<SeTextureLoader::TextureHandle> SeTextureLoader::recordMipGeneration(VkCommandBuffer command_buffer, uint64_t frame_number) {
+    // Runs after the upload ring's acquire barriers, so every complete
+    // upload is owned by the graphics family at this point. Those barriers
+    // leave the image in the layout the upload asked for, which is where
+    // the state tracker takes over
+    std::vector<TextureHandle> ready_textures;
+    ready_textures.swap(m_revived);
+    for (TextureHandle handle = 0; handle < m_textures.size(); handle++) {
+        Texture &texture = m_textures[handle];
+        if (texture.state != State::UPLOADING || texture.released || !m_upload_ring->isComplete(texture.upload)) {
+            continue;
+        }
+        m_state_tracker->registerImage(texture.image, VK_IMAGE_ASPECT_COLOR_BIT, texture.mip_levels, 1, VK_IMAGE_LAYOUT_UNDEFINED);
+        if (texture.transfer_pass) {
+            VkImageSubresourceRange base_level = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            m_state_tracker->resetImage(texture.image, base_level, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+        } else {
+            m_state_tracker->resetImage(texture.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
+        }
+        if (texture.mip_levels > 1) {
+            generateMips(command_buffer, texture);
+        }
+        if (texture.write_cache) {
+            recordReadback(command_buffer, texture, frame_number);
+        }
+        if (texture.transfer_pass) {
+            transitionToShaderRead(command_buffer, texture);
+        }
+        texture.state = State::READY;
+        texture.pixels = QImage();
+        ready_textures.push_back(handle);
+
+        double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - texture.request_time).count();
+        qDebug() << "Texture" << texture.path << texture.extent.width << "x" << texture.extent.height << "with" << texture.mip_levels << "levels ready after" << latency_ms
+                 << "ms, decoding took" << texture.decode_ms << "ms";
+    }
+    return ready_textures;
+}
+
+void SeTextureLoader::generateMips(VkCommandBuffer command_buffer, const Texture &texture) {
+    // Every level below the base is written exactly once
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 1, texture.mip_levels - 1, 0, 1};
+    m_state_tracker->requireImage(texture.image, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    int32_t width = static_cast<int32_t>(texture.extent.width);
+    int32_t height = static_cast<int32_t>(texture.extent.height);
+    for (uint32_t level = 1; level < texture.mip_levels; level++) {
+        int32_t level_width = std::max(1, width / 2);
+        int32_t level_height = std::max(1, height / 2);
+
+        // The level written last is the source of this one
+        range.baseMipLevel = level - 1;
+        range.levelCount = 1;
+        m_state_tracker->requireImage(texture.image, range, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+        m_state_tracker->flush(command_buffer);
+
+        VkImageBlit blit{};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+        blit.srcOffsets[1] = {width, height, 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        blit.dstOffsets[1] = {level_width, level_height, 1};
+        vkCmdBlitImage(command_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        width = level_width;
+        height = level_height;
+    }
+}
+
+void SeTextureLoader::recordReadback(VkCommandBuffer command_buffer, const Texture &texture, uint64_t frame_number) {
+    Readback readback;
+    readback.frame_number = frame_number;
+    readback.cache_key = texture.cache_key;
+    readback.format = texture.format;
+    readback.extent = texture.extent;
+    readback.levels = SeTextureCache::levelLayout(texture.extent, texture.mip_levels, TEXEL_SIZE, readback.data_size);
+    readback.path = texture.path;
+
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = readback.data_size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // Cached memory makes the writer's reads fast, coherent memory is the
+    // fallback every device has
+    VkResult result;
+    result = m_memory_allocator->createBuffer(buffer_info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                              readback.buffer, readback.allocation);
+    if (result != VK_SUCCESS) {
+        result = m_memory_allocator->createBuffer(buffer_info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback.buffer, readback.allocation);
+    }
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create texture read back buffer, not caching" << texture.path;
+        return;
+    }
+
+    // Only a level blitted last still needs a barrier to be read
+    m_state_tracker->requireImage(texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    m_state_tracker->registerBuffer(readback.buffer, readback.data_size);
+    m_state_tracker->requireBuffer(readback.buffer, 0, readback.data_size, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    m_state_tracker->flush(command_buffer);
+
+    std::vector<VkBufferImageCopy> regions(texture.mip_levels);
+    for (uint32_t level = 0; level < texture.mip_levels; level++) {
+        regions[level].bufferOffset = readback.levels[level].offset;
+        regions[level].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        regions[level].imageExtent = {std::max(1u, texture.extent.width >> level), std::max(1u, texture.extent.height >> level), 1};
+    }
+    vkCmdCopyImageToBuffer(command_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+    // The buffer is never used on the device again, so its state goes with
+    // the barrier that makes the copy visible to the cache writer
+    m_state_tracker->requireBuffer(readback.buffer, 0, readback.data_size, VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT);
+    m_state_tracker->flush(command_buffer);
+    m_state_tracker->unregisterBuffer(readback.buffer);
+    m_readbacks.push_back(std::move(readback));
+}
+
+void SeTextureLoader::destroyReadback(Readback &readback) {
+    m_memory_allocator->destroyBuffer(readback.buffer, readback.allocation);
+}
+
+void SeTextureLoader::transitionToShaderRead(VkCommandBuffer command_buffer, const Texture &texture) {
+    // Levels that were left in the same state share a single barrier
+    m_state_tracker->requireImage(texture.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
+    m_state_tracker->flush(command_buffer);
+}
+
+#pragma endregion Mip generation
+
+#pragma region Queries
+bool SeTextureLoader::isReady(TextureHandle handle) const {
+    return handle < m_textures.size() && m_textures[handle].state == State::READY;
+}
+
+bool SeTextureLoader::hasFailed(TextureHandle handle) const {
+    return handle < m_textures.size() && m_textures[handle].state == State::FAILED;
+}
+
+bool SeTextureLoader::isBusy() const {
+    // A pending read back needs frames to complete before it is written
+    if (!m_readbacks.empty() || !m_revived.empty()) {
+        return true;
+    }
+    return std::any_of(m_textures.begin(), m_textures.end(), [](const Texture &texture) { return texture.state == State::DECODING || texture.state == State::UPLOADING; });
+}
+
+VkImageView SeTextureLoader::view(TextureHandle handle) const {
+    assert(handle < m_textures.size());
+    return m_textures[handle].view;
+}
+
+VkSampler SeTextureLoader::sampler() const {
+    return m_sampler;
+}
+
+#pragma endregion Queries
@@ -0,0 +1,181 @@
+#ifndef SE_TEXTURE_LOADER_H
+#define SE_TEXTURE_LOADER_H
+
+#include "SeDeletionQueue.h"
+#include "SeMemoryAllocator.h"
+#include "SeResidencyManager.h"
+#include "SeResourceStateTracker.h"
+#include "SeTextureCache.h"
+#include "SeUploadRing.h"
+#include <QDateTime>
+#include <QImage>
+#include <QString>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Loads image files into sampled textures without stalling the frame loop.
+// Files are decoded to RGBA8 on a pool of worker threads, so every texture
+// of a project decodes at the same time. update() runs on the GUI thread
+// once per frame: it creates the image for every finished decode and queues
+// its base level on the upload ring, keeping the decoded pixels alive until
+// they are staged. Once an upload is complete, recordMipGeneration() fills
+// the remaining levels with a chain of linear blits in the graphics command
+// buffer, each level halving the previous one, and moves the whole image to
+// shader read layout. From then on the window's state tracker knows every
+// level, and all barriers on the image come from it. Formats that cannot be
+// blitted with linear filtering get a single level. Each texture reports how
+// long it took from the load request to the first command buffer able to
+// sample it.
+//
+// With a cache directory, a texture whose source hash has an entry skips
+// decoding and mip generation: its mapped levels go straight to the upload
+// ring. On a miss the generated chain is copied into a host visible buffer
+// in the same command buffer, and once that frame has completed a decode
+// thread writes it out as a new entry.
+//
+// Released textures stay resident as long as their memory heap has room:
+// they are handed to the residency manager, and loading the same unchanged
+// file again brings them back without a single upload. Under memory
+// pressure the manager evicts the least recently released ones first.
+class SeTextureLoader {
+  public:
+    using TextureHandle = uint32_t;
+    static constexpr TextureHandle INVALID_TEXTURE = UINT32_MAX;
+
+    SeTextureLoader();
+    ~SeTextureLoader();
+
+    void init(VkDevice device, VkPhysicalDevice physical_device, SeMemoryAllocator *memory_allocator, SeUploadRing *upload_ring, SeResidencyManager *residency_manager,
+              SeResourceStateTracker *state_tracker, SeDeletionQueue *deletion_queue, const QString &cache_directory = QString(), uint32_t thread_count = 0);
+    void cleanup();
+
+    TextureHandle load(const QString &path, bool srgb = true);
+    void release(TextureHandle texture, uint64_t last_use_frame_number);
+    void update(uint64_t frame_number, uint64_t completed_frame_number);
+    std::vector<TextureHandle> recordMipGeneration(VkCommandBuffer command_buffer, uint64_t frame_number);
+
+    bool isReady(TextureHandle texture) const;
+    bool hasFailed(TextureHandle texture) const;
+    bool isBusy() const;
+    VkImageView view(TextureHandle texture) const;
+    VkSampler sampler() const;
+
+  private:
+    static constexpr uint32_t TEXEL_SIZE = 4;
+
+    enum class State {
+        FREE,
+        DECODING,
+        UPLOADING,
+        READY,
+        // Released but kept resident until evicted or loaded again
+        CACHED,
+        FAILED
+    };
+
+    struct Texture {
+        State state = State::FREE;
+        bool released = false;
+        QString path;
+        QDateTime modified;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        QImage pixels;
+        SeTextureCache::Entry cached;
+        QByteArray cache_key;
+        // Levels below the base are blitted or the chain is read back
+        bool transfer_pass = false;
+        bool write_cache = false;
+        VkImage image = VK_NULL_HANDLE;
+        SeMemoryAllocator::Allocation allocation;
+        VkImageView view = VK_NULL_HANDLE;
+        VkExtent2D extent = {0, 0};
+        uint32_t mip_levels = 1;
+        SeUploadRing::UploadHandle upload = SeUploadRing::INVALID_UPLOAD;
+        SeResidencyManager::EntryHandle residency = SeResidencyManager::INVALID_ENTRY;
+        uint64_t last_use_frame_number = 0;
+        std::chrono::steady_clock::time_point request_time;
+        double decode_ms = 0.0;
+    };
+
+    struct DecodeJob {
+        TextureHandle texture;
+        QString path;
+        VkFormat format;
+    };
+
+    struct DecodeResult {
+        TextureHandle texture;
+        QImage pixels;
+        SeTextureCache::Entry cached;
+        QByteArray cache_key;
+        double decode_ms;
+    };
+
+    // A mip chain copied back for the cache, written once its frame is done
+    struct Readback {
+        uint64_t frame_number = 0;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        SeMemoryAllocator::Allocation allocation;
+        QByteArray cache_key;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {0, 0};
+        std::vector<SeTextureCache::Level> levels;
+        VkDeviceSize data_size = 0;
+        QString path;
+    };
+
+    SeTextureLoader(const SeTextureLoader &) = delete;
+    SeTextureLoader &operator=(const SeTextureLoader &) = delete;
+
+    void workerThread();
+    void decode(DecodeResult &result, const DecodeJob &job) const;
+    void createTexture(Texture &texture);
+    void uploadCachedLevels(Texture &texture);
+    void createSampler();
+    void destroyTexture(Texture &texture, uint64_t last_use_frame_number);
+    TextureHandle reviveTexture(const QString &path, VkFormat format, const QDateTime &modified);
+    void evictTexture(TextureHandle texture);
+    bool supportsMipBlits(VkFormat format) const;
+    void generateMips(VkCommandBuffer command_buffer, const Texture &texture);
+    void recordReadback(VkCommandBuffer command_buffer, const Texture &texture, uint64_t frame_number);
+    void transitionToShaderRead(VkCommandBuffer command_buffer, const Texture &texture);
+    void destroyReadback(Readback &readback);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    SeMemoryAllocator *m_memory_allocator = nullptr;
+    SeUploadRing *m_upload_ring = nullptr;
+    SeResidencyManager *m_residency_manager = nullptr;
+    SeResourceStateTracker *m_state_tracker = nullptr;
+    SeDeletionQueue *m_deletion_queue = nullptr;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    // Set up before the threads start, read only afterwards
+    SeTextureCache m_cache;
+
+    // Indexed by handle, touched by the GUI thread only
+    std::vector<Texture> m_textures;
+    std::vector<TextureHandle> m_free_handles;
+    // Loaded again while cached, bound by the next recorded frame
+    std::vector<TextureHandle> m_revived;
+    // Latest frame passed to update(), no retire may go below it
+    uint64_t m_frame_number = 0;
+    // Waiting for their frame, also GUI thread only
+    std::vector<Readback> m_readbacks;
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_work_condition;
+    std::deque<DecodeJob> m_jobs;
+    std::vector<DecodeResult> m_results;
+    std::deque<Readback> m_write_jobs;
+    std::vector<Readback> m_finished_writes;
+    bool m_stopping = false;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "SeTileScheduler.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+#pragma region Grid
+void SeTileScheduler::setExtent(VkExtent2D extent) {
+    if (extent.width != m_extent.width || extent.height != m_extent.height) {
+        m_extent = extent;
+        updateGrid();
+    }
+}
+
+void SeTileScheduler::setTiling(bool enabled) {
+    if (enabled != m_tiling) {
+        m_tiling = enabled;
+        updateGrid();
+    }
+}
+
+bool SeTileScheduler::isTiling() const {
+    return m_tiling;
+}
+
+void SeTileScheduler::setBudgetMs(double budget_ms) {
+    assert(budget_ms > 0.0);
+    m_budget_ms = budget_ms;
+}
+
+void SeTileScheduler::resetBudget() {
+    // Forget what was learned, e.g. after the estimate turned out too high
+    m_tiles_per_frame = 1;
+    m_tile_ms = 0.0;
+}
+
+void SeTileScheduler::updateGrid() {
+    if (m_tiling) {
+        m_columns = std::max(1u, (m_extent.width + TILE_SIZE - 1) / TILE_SIZE);
+        m_rows = std::max(1u, (m_extent.height + TILE_SIZE - 1) / TILE_SIZE);
+    } else {
+        m_columns = 1;
+        m_rows = 1;
+    }
+    m_tiles_per_frame = std::min(m_tiles_per_frame, tileCount());
+    restart();
+}
+
+uint32_t SeTileScheduler::tileCount() const {
+    return m_columns * m_rows;
+}
+
+uint32_t SeTileScheduler::tilesPerFrame() const {
+    return m_tiles_per_frame;
+}
+
+VkRect2D SeTileScheduler::tileRect(uint32_t tile) const {
+    assert(tile < tileCount());
+    if (!m_tiling) {
+        return {{0, 0}, m_extent};
+    }
+
+    uint32_t x = (tile % m_columns) * TILE_SIZE;
+    uint32_t y = (tile / m_columns) * TILE_SIZE;
+    VkRect2D rect;
+    rect.offset = {static_cast<int32_t>(x), static_cast<int32_t>(y)};
+    rect.extent = {std::min(TILE_SIZE, m_extent.width - x), std::min(TILE_SIZE, m_extent.height - y)};
+    return rect;
+}
+
+#pragma endregion Grid
+
+#pragma region Batches
+void SeTileScheduler::restart() {
+    m_next_tile = 0;
+}
+
+SeTileScheduler::Batch SeTileScheduler::nextBatch() {
+    Batch batch;
+    batch.first_tile = m_next_tile;
+    batch.tile_count = std::min(m_tiles_per_frame, tileCount() - m_next_tile);
+    m_next_tile += batch.tile_count;
+    batch.completes_sweep = m_next_tile == tileCount();
+    if (batch.completes_sweep) {
+        m_next_tile = 0;
+    }
+    return batch;
+}
+
+bool SeTileScheduler::isSweepInProgress() const {
+    return m_next_tile != 0;
+}
+
+void SeTileScheduler::recordGpuTime(uint32_t tile_count, double gpu_ms) {
+    if (!m_tiling || tile_count == 0 || gpu_ms <= 0.0) {
+        return;
+    }
+
+    double tile_ms = gpu_ms / tile_count;
+    m_tile_ms = m_tile_ms > 0.0 ? m_tile_ms + (tile_ms - m_tile_ms) * SMOOTHING : tile_ms;
+
+    // Grow at most twofold per measurement in case a cheap region of the
+    // image made the estimate too optimistic, shrink immediately
+    uint32_t fitting_tiles = static_cast<uint32_t>(std::floor(m_budget_ms / m_tile_ms));
+    uint32_t tiles_per_frame = std::clamp(fitting_tiles, 1u, std::min(tileCount(), m_tiles_per_frame * 2));
+    if (tiles_per_frame != m_tiles_per_frame) {
+        qDebug() << "Tile budget" << m_budget_ms << "ms:" << tiles_per_frame << "of" << tileCount() << "tiles per frame," << m_tile_ms << "ms per tile";
+        m_tiles_per_frame = tiles_per_frame;
+    }
+}
+
+#pragma endregion Batches
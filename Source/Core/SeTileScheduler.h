@@ -0,0 +1,55 @@
+#ifndef SE_TILE_SCHEDULER_H
+#define SE_TILE_SCHEDULER_H
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+// Splits a full screen draw into scissored tiles and hands out as many per
+// frame as fit into a GPU time budget, so a pathological fragment shader is
+// spread over several frames instead of running long enough in a single
+// submission to trip the driver's timeout. The cost per tile is learned from
+// GPU timestamps of earlier batches. With tiling disabled a single tile
+// covers the whole extent and every batch completes a sweep.
+class SeTileScheduler {
+  public:
+    struct Batch {
+        uint32_t first_tile = 0;
+        uint32_t tile_count = 0;
+        bool completes_sweep = false;
+    };
+
+    void setExtent(VkExtent2D extent);
+    void setTiling(bool enabled);
+    bool isTiling() const;
+    void setBudgetMs(double budget_ms);
+    void resetBudget();
+
+    void restart();
+    Batch nextBatch();
+    bool isSweepInProgress() const;
+    void recordGpuTime(uint32_t tile_count, double gpu_ms);
+
+    uint32_t tileCount() const;
+    uint32_t tilesPerFrame() const;
+    VkRect2D tileRect(uint32_t tile) const;
+
+  private:
+    static constexpr uint32_t TILE_SIZE = 128;
+    static constexpr double DEFAULT_BUDGET_MS = 8.0;
+    static constexpr double SMOOTHING = 0.2;
+
+    void updateGrid();
+
+    VkExtent2D m_extent = {0, 0};
+    bool m_tiling = false;
+    double m_budget_ms = DEFAULT_BUDGET_MS;
+
+    uint32_t m_columns = 1;
+    uint32_t m_rows = 1;
+    uint32_t m_next_tile = 0;
+    // Start with a single tile until the first measurement arrives
+    uint32_t m_tiles_per_frame = 1;
+    double m_tile_ms = 0.0;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "SeUniformRing.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+#pragma region Init and cleanup
+SeUniformRing::SeUniformRing() {
+}
+
+SeUniformRing::~SeUniformRing() {
+    cleanup();
+}
+
+void SeUniformRing::init(VkDevice device, SeMemoryAllocator *memory_allocator, SeDescriptorLayoutCache *layout_cache, SeDescriptorAllocator *descriptor_allocator, VkDeviceSize min_offset_alignment,
+                         uint32_t frame_count, VkShaderStageFlags stages, PFN_vkGetBufferDeviceAddressKHR get_buffer_device_address) {
+    assert(device != VK_NULL_HANDLE && memory_allocator != nullptr && layout_cache != nullptr && descriptor_allocator != nullptr && frame_count > 0);
+    m_device = device;
+    m_memory_allocator = memory_allocator;
+    m_alignment = std::max<VkDeviceSize>(min_offset_alignment, 1);
+
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = FRAME_SEGMENT_SIZE * frame_count;
+    buffer_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (get_buffer_device_address) {
+        buffer_info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+    }
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // Coherent memory makes a push a plain memcpy, no flush needed
+    VkResult result;
+    result = m_memory_allocator->createBuffer(buffer_info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffer, m_allocation);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Uniform ring created with" << frame_count << "segments of" << FRAME_SEGMENT_SIZE / 1024 << "KiB";
+    } else {
+        qDebug() << "Failed to create uniform ring!";
+    }
+    assert(result == VK_SUCCESS && m_allocation.mapped != nullptr);
+
+    if (get_buffer_device_address) {
+        VkBufferDeviceAddressInfoKHR address_info{};
+        address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+        address_info.buffer = m_buffer;
+        m_device_address = get_buffer_device_address(m_device, &address_info);
+    }
+
+    createDescriptorSet(layout_cache, descriptor_allocator, stages);
+}
+
+void SeUniformRing::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    // The layout belongs to the cache and the set to the descriptor allocator
+    m_set_layout = VK_NULL_HANDLE;
+    m_descriptor_set = VK_NULL_HANDLE;
+    m_memory_allocator->destroyBuffer(m_buffer, m_allocation);
+    m_segment_begin = 0;
+    m_head = 0;
+    m_device_address = 0;
+    m_memory_allocator = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+void SeUniformRing::createDescriptorSet(SeDescriptorLayoutCache *layout_cache, SeDescriptorAllocator *descriptor_allocator, VkShaderStageFlags stages) {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = stages;
+
+    m_set_layout = layout_cache->layout({binding});
+    m_descriptor_set = descriptor_allocator->allocatePersistent(m_set_layout);
+
+    // Written once, pushes only move the dynamic offset
+    VkDescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = m_buffer;
+    buffer_info.offset = 0;
+    buffer_info.range = MAX_BLOCK_SIZE;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_descriptor_set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+}
+
+VkDescriptorSetLayout SeUniformRing::setLayout() const {
+    return m_set_layout;
+}
+
+VkDescriptorSet SeUniformRing::descriptorSet() const {
+    return m_descriptor_set;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Allocation
+void SeUniformRing::beginFrame(uint32_t frame_index) {
+    // Called after the frame's fence has signaled, so its segment is free
+    m_segment_begin = FRAME_SEGMENT_SIZE * frame_index;
+    assert(m_segment_begin + FRAME_SEGMENT_SIZE <= m_allocation.size);
+    m_head = 0;
+}
+
+bool SeUniformRing::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize reserved_size, VkDeviceSize &buffer_offset) {
+    VkDeviceSize offset = (m_head + alignment - 1) / alignment * alignment;
+    if (offset + reserved_size > FRAME_SEGMENT_SIZE) {
+        qDebug() << "Uniform ring segment full!";
+        return false;
+    }
+    m_head = offset + size;
+    buffer_offset = m_segment_begin + offset;
+    return true;
+}
+
+uint32_t SeUniformRing::push(const void *data, VkDeviceSize size) {
+    assert(size <= MAX_BLOCK_SIZE);
+    // The bound range has to stay inside the segment as well
+    VkDeviceSize buffer_offset = 0;
+    if (!allocate(size, m_alignment, MAX_BLOCK_SIZE, buffer_offset)) {
+        return INVALID_OFFSET;
+    }
+    std::memcpy(static_cast<char *>(m_allocation.mapped) + buffer_offset, data, size);
+    return static_cast<uint32_t>(buffer_offset);
+}
+
+VkDeviceAddress SeUniformRing::pushBlock(const void *data, VkDeviceSize size) {
+    assert(supportsBlocks());
+    VkDeviceSize buffer_offset = 0;
+    if (!allocate(size, BLOCK_ALIGNMENT, size, buffer_offset)) {
+        return 0;
+    }
+    std::memcpy(static_cast<char *>(m_allocation.mapped) + buffer_offset, data, size);
+    return m_device_address + buffer_offset;
+}
+
+bool SeUniformRing::supportsBlocks() const {
+    return m_device_address != 0;
+}
+
+VkDeviceSize SeUniformRing::usedBytes() const {
+    return m_head;
+}
+
+#pragma endregion Allocation
@@ -0,0 +1,70 @@
+#ifndef SE_UNIFORM_RING_H
+#define SE_UNIFORM_RING_H
+
+#include "SeDescriptorAllocator.h"
+#include "SeDescriptorLayoutCache.h"
+#include "SeMemoryAllocator.h"
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+// Per-frame uniforms without per-frame allocations or descriptor writes. One
+// persistently mapped, host coherent buffer is split into a segment per frame
+// in flight, and every push bump-allocates from the current frame's segment.
+// The single descriptor set, a persistent one from the caller's descriptor
+// allocator, is written once as a dynamic uniform buffer, so binding a push
+// only costs its dynamic offset. A segment is reused once the fence of its
+// frame has signaled. With buffer device address the ring also takes
+// parameter blocks of any size that fits a segment; shaders read them through
+// the 64-bit address passed in push constants, without descriptors.
+class SeUniformRing {
+  public:
+    static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+    SeUniformRing();
+    ~SeUniformRing();
+
+    // get_buffer_device_address is nullptr when blocks are not supported
+    void init(VkDevice device, SeMemoryAllocator *memory_allocator, SeDescriptorLayoutCache *layout_cache, SeDescriptorAllocator *descriptor_allocator, VkDeviceSize min_offset_alignment, uint32_t frame_count, VkShaderStageFlags stages,
+              PFN_vkGetBufferDeviceAddressKHR get_buffer_device_address = nullptr);
+    void cleanup();
+
+    VkDescriptorSetLayout setLayout() const;
+    VkDescriptorSet descriptorSet() const;
+
+    void beginFrame(uint32_t frame_index);
+    uint32_t push(const void *data, VkDeviceSize size);
+    template <typename T> uint32_t push(const T &value) {
+        return push(&value, sizeof(T));
+    }
+    VkDeviceAddress pushBlock(const void *data, VkDeviceSize size);
+    bool supportsBlocks() const;
+    VkDeviceSize usedBytes() const;
+
+  private:
+    static constexpr VkDeviceSize FRAME_SEGMENT_SIZE = 1024 * 1024;
+    // Range of the dynamic binding, every push has to fit into it
+    static constexpr VkDeviceSize MAX_BLOCK_SIZE = 256;
+    // Enough for any scalar or std430 member read through an address
+    static constexpr VkDeviceSize BLOCK_ALIGNMENT = 16;
+
+    SeUniformRing(const SeUniformRing &) = delete;
+    SeUniformRing &operator=(const SeUniformRing &) = delete;
+
+    void createDescriptorSet(SeDescriptorLayoutCache *layout_cache, SeDescriptorAllocator *descriptor_allocator, VkShaderStageFlags stages);
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize reserved_size, VkDeviceSize &buffer_offset);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    SeMemoryAllocator *m_memory_allocator = nullptr;
+    VkDeviceSize m_alignment = 1;
+
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    SeMemoryAllocator::Allocation m_allocation;
+    VkDeviceSize m_segment_begin = 0;
+    VkDeviceSize m_head = 0;
+    VkDeviceAddress m_device_address = 0;
+
+    VkDescriptorSetLayout m_set_layout = VK_NULL_HANDLE;
+    VkDescriptorSet m_descriptor_set = VK_NULL_HANDLE;
+};
+
+#endif
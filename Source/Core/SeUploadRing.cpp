@@ -0,0 +1,483 @@
+#include "SeUploadRing.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#pragma region Init and cleanup
+SeUploadRing::SeUploadRing() {
+}
+
+SeUploadRing::~SeUploadRing() {
+    cleanup();
+}
+
+void SeUploadRing::init(VkDevice device, SeMemoryAllocator *memory_allocator, VkQueue transfer_queue, uint32_t transfer_family, VkExtent3D transfer_granularity, uint32_t graphics_family) {
+    assert(device != VK_NULL_HANDLE && memory_allocator != nullptr && transfer_queue != VK_NULL_HANDLE);
+    m_device = device;
+    m_memory_allocator = memory_allocator;
+    m_transfer_queue = transfer_queue;
+    m_transfer_family = transfer_family;
+    m_transfer_granularity = transfer_granularity;
+    m_graphics_family = graphics_family;
+
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = RING_SIZE;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult result;
+    result = m_memory_allocator->createBuffer(buffer_info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_ring_buffer, m_ring_allocation);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Upload ring created with" << RING_SIZE / (1024 * 1024) << "MiB on queue family" << m_transfer_family
+                 << (needsOwnershipTransfer() ? "with ownership transfer" : "");
+    } else {
+        qDebug() << "Failed to create upload ring!";
+    }
+    assert(result == VK_SUCCESS && m_ring_allocation.mapped != nullptr);
+
+    createBatches();
+}
+
+void SeUploadRing::cleanup() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    // The owner waits for the device to be idle before cleaning up
+    destroyBatches();
+    m_memory_allocator->destroyBuffer(m_ring_buffer, m_ring_allocation);
+    m_head = 0;
+    m_tail = 0;
+    m_pending_uploads.clear();
+    m_released_uploads.clear();
+    m_completed_handle = m_next_handle;
+    m_staged_handle = m_next_handle;
+    m_memory_allocator = nullptr;
+    m_transfer_queue = VK_NULL_HANDLE;
+    m_device = VK_NULL_HANDLE;
+}
+
+void SeUploadRing::createBatches() {
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = m_transfer_family;
+
+    VkResult result;
+    result = vkCreateCommandPool(m_device, &pool_info, nullptr, &m_command_pool);
+    assert(result == VK_SUCCESS);
+
+    VkCommandBuffer command_buffers[MAX_BATCHES];
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = m_command_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = MAX_BATCHES;
+    result = vkAllocateCommandBuffers(m_device, &alloc_info, command_buffers);
+    assert(result == VK_SUCCESS);
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    for (uint32_t i = 0; i < MAX_BATCHES; i++) {
+        m_batches[i].command_buffer = command_buffers[i];
+        result = vkCreateFence(m_device, &fence_info, nullptr, &m_batches[i].fence);
+        assert(result == VK_SUCCESS);
+    }
+}
+
+void SeUploadRing::destroyBatches() {
+    for (auto &batch : m_batches) {
+        destroyStagingBuffers(batch);
+        if (batch.fence) {
+            vkDestroyFence(m_device, batch.fence, nullptr);
+        }
+        batch = Batch{};
+    }
+    m_in_flight_batches.clear();
+    if (m_command_pool) {
+        vkDestroyCommandPool(m_device, m_command_pool, nullptr);
+        m_command_pool = VK_NULL_HANDLE;
+    }
+}
+
+bool SeUploadRing::needsOwnershipTransfer() const {
+    return m_transfer_family != m_graphics_family;
+}
+
+#pragma endregion Init and cleanup
+
+#pragma region Uploads
+SeUploadRing::UploadHandle SeUploadRing::uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size, VkPipelineStageFlags dst_stages, VkAccessFlags dst_accesses) {
+    assert(buffer != VK_NULL_HANDLE && data != nullptr && size > 0);
+    Upload upload;
+    upload.handle = m_next_handle++;
+    upload.buffer = buffer;
+    upload.buffer_offset = offset;
+    upload.data = static_cast<const uint8_t *>(data);
+    upload.size = size;
+    upload.dst_stages = dst_stages;
+    upload.dst_accesses = dst_accesses;
+    m_pending_uploads.push_back(upload);
+    return upload.handle;
+}
+
+SeUploadRing::UploadHandle SeUploadRing::uploadImage(VkImage image, const ImageRegion &region, const void *data, VkDeviceSize size, VkImageLayout final_layout, VkPipelineStageFlags dst_stages, VkAccessFlags dst_accesses) {
+    assert(image != VK_NULL_HANDLE && data != nullptr && region.block_size > 0 && region.block_extent > 0);
+    Upload upload;
+    upload.handle = m_next_handle++;
+    upload.image = image;
+    upload.region = region;
+    // Images are chunked by whole rows of blocks within one depth slice
+    uint32_t blocks_per_row = (region.extent.width + region.block_extent - 1) / region.block_extent;
+    upload.row_size = VkDeviceSize(blocks_per_row) * region.block_size;
+    upload.rows_per_slice = (region.extent.height + region.block_extent - 1) / region.block_extent;
+    upload.data = static_cast<const uint8_t *>(data);
+    upload.size = size;
+    upload.final_layout = final_layout;
+    upload.dst_stages = dst_stages;
+    upload.dst_accesses = dst_accesses;
+    assert(size == upload.row_size * upload.rows_per_slice * region.extent.depth);
+    assert(upload.row_size <= MAX_CHUNK_SIZE);
+    // The granularity counts blocks for compressed formats, like the rows do.
+    // Single slices only meet it when it is one deep or the image is flat
+    bool zero_granularity = m_transfer_granularity.width == 0 || m_transfer_granularity.height == 0 || m_transfer_granularity.depth == 0;
+    upload.whole_subresource = zero_granularity || (m_transfer_granularity.depth > 1 && region.extent.depth > 1);
+    upload.row_granularity = upload.whole_subresource ? upload.rows_per_slice : std::min(m_transfer_granularity.height, upload.rows_per_slice);
+    m_pending_uploads.push_back(upload);
+    return upload.handle;
+}
+
+bool SeUploadRing::isStaged(UploadHandle upload) const {
+    return upload < m_staged_handle;
+}
+
+bool SeUploadRing::isComplete(UploadHandle upload) const {
+    return upload < m_completed_handle;
+}
+
+bool SeUploadRing::isIdle() const {
+    return m_pending_uploads.empty() && m_in_flight_batches.empty() && m_released_uploads.empty();
+}
+
+#pragma endregion Uploads
+
+#pragma region Staging
+bool SeUploadRing::allocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+    // The ring is empty exactly when head and tail meet, so an allocation may
+    // never make them meet again
+    VkDeviceSize aligned_head = (m_head + alignment - 1) / alignment * alignment;
+    if (m_head >= m_tail) {
+        if (aligned_head + size <= RING_SIZE) {
+            offset = aligned_head;
+            m_head = aligned_head + size;
+            return true;
+        }
+        // Wrap around, the skipped end is reclaimed with the batch
+        if (size < m_tail) {
+            offset = 0;
+            m_head = size;
+            return true;
+        }
+        return false;
+    }
+    if (aligned_head + size < m_tail) {
+        offset = aligned_head;
+        m_head = aligned_head + size;
+        return true;
+    }
+    return false;
+}
+
+bool SeUploadRing::createStagingBuffer(VkDeviceSize size, StagingBuffer &staging_buffer) {
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult result;
+    result = m_memory_allocator->createBuffer(buffer_info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer.buffer, staging_buffer.allocation);
+    if (result != VK_SUCCESS) {
+        // Retried by the next pump, once memory has been released
+        qDebug() << "Failed to create a staging buffer of" << size / (1024 * 1024) << "MiB:" << result;
+        return false;
+    }
+    assert(staging_buffer.allocation.mapped != nullptr);
+    return true;
+}
+
+void SeUploadRing::destroyStagingBuffers(Batch &batch) {
+    for (auto &staging_buffer : batch.staging_buffers) {
+        m_memory_allocator->destroyBuffer(staging_buffer.buffer, staging_buffer.allocation);
+    }
+    batch.staging_buffers.clear();
+}
+
+bool SeUploadRing::stageChunk(Batch &batch, Upload &upload, VkDeviceSize budget, VkDeviceSize &staged) {
+    VkCommandBuffer command_buffer = batch.command_buffer;
+    VkDeviceSize remaining = upload.size - upload.staged_bytes;
+    VkDeviceSize ring_offset = 0;
+
+    if (upload.buffer) {
+        VkDeviceSize chunk_size = std::min({remaining, MAX_CHUNK_SIZE, budget});
+        if (chunk_size == 0 || !allocateRing(chunk_size, 4, ring_offset)) {
+            return false;
+        }
+        std::memcpy(static_cast<uint8_t *>(m_ring_allocation.mapped) + ring_offset, upload.data + upload.staged_bytes, chunk_size);
+
+        VkBufferCopy copy_region{};
+        copy_region.srcOffset = ring_offset;
+        copy_region.dstOffset = upload.buffer_offset + upload.staged_bytes;
+        copy_region.size = chunk_size;
+        vkCmdCopyBuffer(command_buffer, m_ring_buffer, upload.buffer, 1, &copy_region);
+
+        upload.staged_bytes += chunk_size;
+        staged += chunk_size;
+        return true;
+    }
+
+    const ImageRegion &region = upload.region;
+    uint32_t row = static_cast<uint32_t>(upload.staged_bytes / upload.row_size);
+    uint32_t slice = row / upload.rows_per_slice;
+    uint32_t slice_row = row % upload.rows_per_slice;
+    // At least one granularity step per chunk, so steps wider than the budget
+    // still move. Chunks start on a step and only the last one of a slice
+    // may be shorter, where it ends at the image edge
+    VkDeviceSize step_size = upload.row_size * upload.row_granularity;
+    uint32_t step_count = static_cast<uint32_t>(std::max<VkDeviceSize>(1, std::min(MAX_CHUNK_SIZE, budget) / step_size));
+    uint32_t row_count = std::min<uint32_t>(upload.rows_per_slice - slice_row, step_count * upload.row_granularity);
+    uint32_t slice_count = 1;
+    if (upload.whole_subresource) {
+        row_count = upload.rows_per_slice;
+        slice_count = region.extent.depth;
+    }
+    VkDeviceSize chunk_size = upload.row_size * row_count * slice_count;
+    VkDeviceSize alignment = std::lcm<VkDeviceSize>(region.block_size, 4);
+    if (budget == 0) {
+        return false;
+    }
+    // Only whole subresources grow past the ring, they would never fit and
+    // hold back every later upload
+    VkBuffer source_buffer = m_ring_buffer;
+    uint8_t *source_memory = nullptr;
+    if (chunk_size >= RING_SIZE) {
+        StagingBuffer staging_buffer;
+        if (!createStagingBuffer(chunk_size, staging_buffer)) {
+            return false;
+        }
+        batch.staging_buffers.push_back(staging_buffer);
+        source_buffer = staging_buffer.buffer;
+        source_memory = static_cast<uint8_t *>(staging_buffer.allocation.mapped);
+    } else if (allocateRing(chunk_size, alignment, ring_offset)) {
+        source_memory = static_cast<uint8_t *>(m_ring_allocation.mapped) + ring_offset;
+    } else {
+        return false;
+    }
+    std::memcpy(source_memory, upload.data + upload.staged_bytes, chunk_size);
+
+    if (upload.staged_bytes == 0) {
+        VkImageMemoryBarrier barrier = imageBarrier(upload, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    uint32_t first_texel_row = slice_row * region.block_extent;
+    VkBufferImageCopy copy_region{};
+    copy_region.bufferOffset = ring_offset;
+    copy_region.bufferRowLength = 0;
+    copy_region.bufferImageHeight = 0;
+    copy_region.imageSubresource.aspectMask = region.aspect_mask;
+    copy_region.imageSubresource.mipLevel = region.mip_level;
+    copy_region.imageSubresource.baseArrayLayer = region.array_layer;
+    copy_region.imageSubresource.layerCount = 1;
+    copy_region.imageOffset = {0, static_cast<int32_t>(first_texel_row), static_cast<int32_t>(slice)};
+    copy_region.imageExtent = {region.extent.width, std::min(row_count * region.block_extent, region.extent.height - first_texel_row), slice_count};
+    vkCmdCopyBufferToImage(command_buffer, source_buffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
+
+    upload.staged_bytes += chunk_size;
+    staged += chunk_size;
+    return true;
+}
+
+VkResult SeUploadRing::pump() {
+    VkResult result;
+    result = retireBatches();
+    if (result != VK_SUCCESS || m_pending_uploads.empty() || m_in_flight_batches.size() == MAX_BATCHES) {
+        return result;
+    }
+
+    uint32_t batch_index = m_in_flight_batches.empty() ? 0 : (m_in_flight_batches.back() + 1) % MAX_BATCHES;
+    Batch &batch = m_batches[batch_index];
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    result = vkBeginCommandBuffer(batch.command_buffer, &begin_info);
+    assert(result == VK_SUCCESS);
+
+    // Uploads are staged strictly in order, a stalled one holds back the rest
+    VkDeviceSize staged = 0;
+    while (!m_pending_uploads.empty()) {
+        Upload &upload = m_pending_uploads.front();
+        VkDeviceSize budget = staged < PUMP_BUDGET ? PUMP_BUDGET - staged : 0;
+        if (!stageChunk(batch, upload, budget, staged)) {
+            break;
+        }
+        if (upload.staged_bytes == upload.size) {
+            recordRelease(batch.command_buffer, upload);
+            m_staged_handle = upload.handle + 1;
+            batch.finished_uploads.push_back(upload);
+            m_pending_uploads.pop_front();
+        }
+    }
+
+    result = vkEndCommandBuffer(batch.command_buffer);
+    assert(result == VK_SUCCESS);
+    if (staged == 0) {
+        return VK_SUCCESS;
+    }
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &batch.command_buffer;
+
+    vkResetFences(m_device, 1, &batch.fence);
+    result = vkQueueSubmit(m_transfer_queue, 1, &submit_info, batch.fence);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to submit upload batch: " << result;
+        return result;
+    }
+    batch.ring_end = m_head;
+    m_in_flight_batches.push_back(batch_index);
+    return VK_SUCCESS;
+}
+
+VkResult SeUploadRing::retireBatches() {
+    while (!m_in_flight_batches.empty()) {
+        Batch &batch = m_batches[m_in_flight_batches.front()];
+        VkResult result = vkGetFenceStatus(m_device, batch.fence);
+        if (result == VK_NOT_READY) {
+            break;
+        }
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        m_tail = batch.ring_end;
+        destroyStagingBuffers(batch);
+        finishUploads(batch.finished_uploads);
+        batch.finished_uploads.clear();
+        m_in_flight_batches.pop_front();
+    }
+    if (m_in_flight_batches.empty()) {
+        m_head = 0;
+        m_tail = 0;
+    }
+    return VK_SUCCESS;
+}
+
+void SeUploadRing::finishUploads(std::vector<Upload> &uploads) {
+    if (uploads.empty()) {
+        return;
+    }
+    if (needsOwnershipTransfer()) {
+        // Complete once the graphics family has acquired them
+        m_released_uploads.insert(m_released_uploads.end(), uploads.begin(), uploads.end());
+    } else {
+        m_completed_handle = uploads.back().handle + 1;
+    }
+}
+
+#pragma endregion Staging
+
+#pragma region Ownership transfer
+VkImageMemoryBarrier SeUploadRing::imageBarrier(const Upload &upload, VkImageLayout old_layout, VkImageLayout new_layout) const {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = m_transfer_family;
+    barrier.dstQueueFamilyIndex = m_graphics_family;
+    barrier.image = upload.image;
+    barrier.subresourceRange.aspectMask = upload.region.aspect_mask;
+    barrier.subresourceRange.baseMipLevel = upload.region.mip_level;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = upload.region.array_layer;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+VkBufferMemoryBarrier SeUploadRing::bufferBarrier(const Upload &upload) const {
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = m_transfer_family;
+    barrier.dstQueueFamilyIndex = m_graphics_family;
+    barrier.buffer = upload.buffer;
+    barrier.offset = upload.buffer_offset;
+    barrier.size = upload.size;
+    return barrier;
+}
+
+void SeUploadRing::recordRelease(VkCommandBuffer command_buffer, const Upload &upload) const {
+    // Within one family the barrier makes the copy visible directly; across
+    // families it is the release half, whose destination scope is ignored
+    bool transfer = needsOwnershipTransfer();
+    VkPipelineStageFlags dst_stages = transfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : upload.dst_stages;
+    VkAccessFlags dst_accesses = transfer ? 0 : upload.dst_accesses;
+
+    if (upload.image) {
+        VkImageMemoryBarrier barrier = imageBarrier(upload, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, upload.final_layout);
+        if (!transfer) {
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        }
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dst_accesses;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    } else {
+        VkBufferMemoryBarrier barrier = bufferBarrier(upload);
+        if (!transfer) {
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        }
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dst_accesses;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+}
+
+void SeUploadRing::recordAcquireBarriers(VkCommandBuffer command_buffer) {
+    if (m_released_uploads.empty()) {
+        return;
+    }
+    // The release batch has already signaled its fence, so the acquire in a
+    // later graphics submission is ordered after it without a semaphore
+    std::vector<VkImageMemoryBarrier> image_barriers;
+    std::vector<VkBufferMemoryBarrier> buffer_barriers;
+    VkPipelineStageFlags dst_stages = 0;
+    for (const auto &upload : m_released_uploads) {
+        if (upload.image) {
+            VkImageMemoryBarrier barrier = imageBarrier(upload, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, upload.final_layout);
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = upload.dst_accesses;
+            image_barriers.push_back(barrier);
+        } else {
+            VkBufferMemoryBarrier barrier = bufferBarrier(upload);
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = upload.dst_accesses;
+            buffer_barriers.push_back(barrier);
+        }
+        dst_stages |= upload.dst_stages;
+    }
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dst_stages != 0 ? dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(), static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+
+    m_completed_handle = m_released_uploads.back().handle + 1;
+    m_released_uploads.clear();
+}
+
+#pragma endregion Ownership transfer
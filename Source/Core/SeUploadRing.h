@@ -0,0 +1,138 @@
+#ifndef SE_UPLOAD_RING_H
+#define SE_UPLOAD_RING_H
+
+#include "SeMemoryAllocator.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Streams buffer and image data to device local memory through one
+// persistently mapped staging ring. Uploads are queued and cut into chunks;
+// every pump() copies as many chunks as the free ring space and the per pump
+// budget allow, records the copies into one command buffer and submits it to
+// the transfer queue without waiting. Ring space is reclaimed once the fence
+// of its batch has signaled. When the transfer queue belongs to another
+// family, the last chunk releases the resource to the graphics family and the
+// matching acquire barrier is recorded into the next graphics command buffer
+// by recordAcquireBarriers(). Image chunks follow the minimum transfer
+// granularity of the transfer family: rows are rounded to it, and when it is
+// zero or coarser than one depth slice the whole subresource is staged at
+// once, through a staging buffer of its own when it is too large for the
+// ring. The source data has to stay alive
+// until the upload is staged, so the caller never pays for an extra copy, and
+// the destination must not be in use by the GPU while the upload runs.
+class SeUploadRing {
+  public:
+    using UploadHandle = uint64_t;
+    static constexpr UploadHandle INVALID_UPLOAD = 0;
+
+    struct ImageRegion {
+        VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT;
+        uint32_t mip_level = 0;
+        uint32_t array_layer = 0;
+        VkExtent3D extent{};
+        // Bytes per texel or per compressed block, and the texels along each
+        // side of a block, 4 for block compressed formats
+        uint32_t block_size = 4;
+        uint32_t block_extent = 1;
+    };
+
+    SeUploadRing();
+    ~SeUploadRing();
+
+    void init(VkDevice device, SeMemoryAllocator *memory_allocator, VkQueue transfer_queue, uint32_t transfer_family, VkExtent3D transfer_granularity, uint32_t graphics_family);
+    void cleanup();
+
+    UploadHandle uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size, VkPipelineStageFlags dst_stages, VkAccessFlags dst_accesses);
+    UploadHandle uploadImage(VkImage image, const ImageRegion &region, const void *data, VkDeviceSize size, VkImageLayout final_layout, VkPipelineStageFlags dst_stages, VkAccessFlags dst_accesses);
+
+    VkResult pump();
+    void recordAcquireBarriers(VkCommandBuffer command_buffer);
+    bool isStaged(UploadHandle upload) const;
+    bool isComplete(UploadHandle upload) const;
+    bool isIdle() const;
+
+  private:
+    static constexpr VkDeviceSize RING_SIZE = 32 * 1024 * 1024;
+    static constexpr VkDeviceSize MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+    // Bytes copied into the ring per pump, bounds the time spent in memcpy
+    static constexpr VkDeviceSize PUMP_BUDGET = 8 * 1024 * 1024;
+    static constexpr uint32_t MAX_BATCHES = 8;
+
+    struct Upload {
+        UploadHandle handle = INVALID_UPLOAD;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize buffer_offset = 0;
+        VkImage image = VK_NULL_HANDLE;
+        ImageRegion region;
+        VkDeviceSize row_size = 0;
+        uint32_t rows_per_slice = 0;
+        // Rows of blocks every chunk but the last of a slice is a multiple of
+        uint32_t row_granularity = 1;
+        bool whole_subresource = false;
+        const uint8_t *data = nullptr;
+        VkDeviceSize size = 0;
+        VkDeviceSize staged_bytes = 0;
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags dst_stages = 0;
+        VkAccessFlags dst_accesses = 0;
+    };
+
+    struct StagingBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        SeMemoryAllocator::Allocation allocation;
+    };
+
+    struct Batch {
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        // Ring position after this batch, the ring tail once it retires
+        VkDeviceSize ring_end = 0;
+        std::vector<Upload> finished_uploads;
+        // Oversized whole subresource copies, destroyed when the batch retires
+        std::vector<StagingBuffer> staging_buffers;
+    };
+
+    SeUploadRing(const SeUploadRing &) = delete;
+    SeUploadRing &operator=(const SeUploadRing &) = delete;
+
+    void createBatches();
+    void destroyBatches();
+    VkResult retireBatches();
+    bool allocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+    bool createStagingBuffer(VkDeviceSize size, StagingBuffer &staging_buffer);
+    void destroyStagingBuffers(Batch &batch);
+    bool stageChunk(Batch &batch, Upload &upload, VkDeviceSize budget, VkDeviceSize &staged);
+    void recordRelease(VkCommandBuffer command_buffer, const Upload &upload) const;
+    VkImageMemoryBarrier imageBarrier(const Upload &upload, VkImageLayout old_layout, VkImageLayout new_layout) const;
+    VkBufferMemoryBarrier bufferBarrier(const Upload &upload) const;
+    void finishUploads(std::vector<Upload> &uploads);
+    bool needsOwnershipTransfer() const;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    SeMemoryAllocator *m_memory_allocator = nullptr;
+    VkQueue m_transfer_queue = VK_NULL_HANDLE;
+    uint32_t m_transfer_family = 0;
+    VkExtent3D m_transfer_granularity{};
+    uint32_t m_graphics_family = 0;
+
+    VkBuffer m_ring_buffer = VK_NULL_HANDLE;
+    SeMemoryAllocator::Allocation m_ring_allocation;
+    VkDeviceSize m_head = 0;
+    VkDeviceSize m_tail = 0;
+
+    VkCommandPool m_command_pool = VK_NULL_HANDLE;
+    Batch m_batches[MAX_BATCHES];
+    // Submission order, batches retire from the front
+    std::deque<uint32_t> m_in_flight_batches;
+
+    UploadHandle m_next_handle = 1;
+    std::deque<Upload> m_pending_uploads;
+    std::vector<Upload> m_released_uploads;
+    // Every upload below this handle is complete, uploads finish in order
+    UploadHandle m_completed_handle = 1;
+    UploadHandle m_staged_handle = 1;
+};
+
+#endif
@@ -63,6 +63,7 @@ void SeVulkanManager::init() {
 }
 
 void SeVulkanManager::cleanup() {
+    m_device_contexts.clear();
     destoryInstance();
 }
 
@@ -81,7 +82,8 @@ void SeVulkanManager::createInstance() {
     application_info.apiVersion = VK_MAKE_VERSION(1, 0, 0);
     application_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     application_info.pEngineName = "SeVulkanInstance";
-    application_info.apiVersion = VK_API_VERSION_1_0;
+    // Devices are still checked individually before newer core features are used
+    application_info.apiVersion = VK_API_VERSION_1_3;
     application_info.pNext = nullptr;
 
     VkInstanceCreateInfo create_info{};
@@ -95,7 +97,7 @@ void SeVulkanManager::createInstance() {
     create_info.pNext = nullptr;
 
     VkResult result;
-    vkCreateInstance(&create_info, nullptr, &m_vulkan_instance);
+    result = vkCreateInstance(&create_info, nullptr, &m_vulkan_instance);
     if (result == VK_SUCCESS) {
         qDebug() << "Vulkan instance created";
     } else {
@@ -157,7 +159,12 @@ VkPhysicalDevice SeVulkanManager::getBestDevice(const VkSurfaceKHR surface, cons
             score += 500;
         }
 
-        score += memory_properties.memoryHeaps[0].size / (1024 * 1024);
+        // Heap 0 is not always the device local one
+        for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++) {
+            if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                score += static_cast<int>(memory_properties.memoryHeaps[i].size / (1024 * 1024));
+            }
+        }
 
         if (score > maxScore && isDeviceSuitable(device, surface, device_extensions)) {
             maxScore = score;
@@ -176,6 +183,51 @@ VkPhysicalDevice SeVulkanManager::getBestDevice(const VkSurfaceKHR surface, cons
 }
 #pragma endregion Physical device
 
+#pragma region Device context
+SeDeviceContext *SeVulkanManager::acquireDeviceContext(const VkSurfaceKHR surface, const void *user, SeDeviceContext::DeviceLostHandler &&device_lost_handler) {
+    // A lost device is never shared again, it goes away with its last user
+    // while the new device for the same surface is already in use
+    SeDeviceContext *device_context = nullptr;
+    for (SeDeviceContext &shared_context : m_device_contexts) {
+        if (!shared_context.isDeviceLost() && shared_context.supportsSurface(surface)) {
+            device_context = &shared_context;
+            break;
+        }
+    }
+    if (device_context == nullptr) {
+        // Surfaces the shared devices cannot present to get a device of their own
+        if (!m_device_contexts.empty()) {
+            qDebug() << "Shared device cannot present to the window surface, creating a separate one";
+        }
+        m_device_contexts.emplace_back();
+        device_context = &m_device_contexts.back();
+        device_context->init(this, surface);
+        if (!device_context->isInitialized()) {
+            qDebug() << "Failed to create a device for the window surface!";
+            m_device_contexts.pop_back();
+            return nullptr;
+        }
+    }
+    device_context->addUser(user, std::move(device_lost_handler));
+    qDebug() << "Device context shared by" << device_context->userCount() << "windows";
+    return device_context;
+}
+
+void SeVulkanManager::releaseDeviceContext(const void *user) {
+    for (auto itr = m_device_contexts.begin(); itr != m_device_contexts.end(); ++itr) {
+        if (!itr->hasUser(user)) {
+            continue;
+        }
+        itr->removeUser(user);
+        if (itr->userCount() == 0) {
+            m_device_contexts.erase(itr);
+        }
+        return;
+    }
+}
+
+#pragma endregion Device context
+
 #pragma region Device verification
 bool SeVulkanManager::isDeviceSuitable(const VkPhysicalDevice device, const VkSurfaceKHR surface, const std::vector<const char *> &device_extensions) const {
     return findQueueFamilies(device, surface).isComplete() && checkDeviceExtensionSupport(device, device_extensions) && querySwapChainSupport(device, surface).isSwapChainAdequate();
@@ -189,23 +241,31 @@ SeQueueFamilyIndices SeVulkanManager::findQueueFamilies(const VkPhysicalDevice d
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
     std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families.data());
-    int i = 0;
-    for (const auto &queue_family : queue_families) {
-        if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-            // VK_QUEUE_COMPUTE_BIT for compute shader and VK_QUEUE_TRANSFER_BIT for data transfer
+    // Every family is visited, the dedicated ones are usually listed last
+    for (uint32_t i = 0; i < queue_family_count; i++) {
+        VkQueueFlags flags = queue_families[i].queueFlags;
+        if (queue_families[i].queueCount == 0) {
+            continue;
+        }
+
+        bool graphics = (flags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        if (graphics && !indices.graphic_family.has_value()) {
             indices.graphic_family = i;
         }
 
+        // Presenting from the graphics family avoids an ownership transfer
         VkBool32 present_support = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
-        if (present_support) {
+        if (present_support && (!indices.present_family.has_value() || (graphics && indices.graphic_family == i))) {
             indices.present_family = i;
         }
 
-        if (indices.isComplete()) {
-            break;
+        if (!graphics && (flags & VK_QUEUE_COMPUTE_BIT) && !indices.compute_family.has_value()) {
+            indices.compute_family = i;
+        }
+        if (!graphics && !(flags & VK_QUEUE_COMPUTE_BIT) && (flags & VK_QUEUE_TRANSFER_BIT) && !indices.transfer_family.has_value()) {
+            indices.transfer_family = i;
         }
-        i++;
     }
     return indices;
 }
@@ -2,9 +2,11 @@
 #define SE_VULKAN_MANAGER_H
 #define VK_USE_PLATFORM_WIN32_KHR
 
+#include "SeDeviceContext.h"
 #include "SeQueueFamilyIndices.h"
 #include "SeSwapChainSupportDetails.h"
 #include <cstdint>
+#include <list>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_win32.h>
@@ -26,6 +28,9 @@ class SeVulkanManager {
 
     void enumerateDevice();
 
+    SeDeviceContext *acquireDeviceContext(const VkSurfaceKHR surface, const void *user, SeDeviceContext::DeviceLostHandler &&device_lost_handler);
+    void releaseDeviceContext(const void *user);
+
     VkPhysicalDevice getBestDevice(const VkSurfaceKHR surface, const std::vector<const char *> &device_extensions) const;
     bool isDeviceSuitable(const VkPhysicalDevice device, const VkSurfaceKHR surface, const std::vector<const char *> &device_extensions) const;
     SeQueueFamilyIndices findQueueFamilies(const VkPhysicalDevice device, const VkSurfaceKHR surface) const;
@@ -38,6 +43,8 @@ class SeVulkanManager {
 
     VkInstance m_vulkan_instance = VK_NULL_HANDLE;
     std::vector<VkPhysicalDevice> m_physical_devices;
+    // A list keeps the contexts in place while windows hold pointers to them
+    std::list<SeDeviceContext> m_device_contexts;
 };
 
 #endif
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include "SeVulkanWindow.h"
 #include "Util/SeUtil.h"
 #include <QDebug>
+#include <QExposeEvent>
+#include <QMouseEvent>
+#include <QResizeEvent>
+#include <QStandardPaths>
 #include <algorithm>
-#include <set>
+#include <cstddef>
+#include <chrono>
+#include <thread>
 
 #pragma region Init and cleanup
 SeVulkanWindow::SeVulkanWindow(SeVulkanManager *vulkan_manager) : m_vulkan_manager(vulkan_manager) {
@@ -19,24 +25,85 @@ SeVulkanWindow::~SeVulkanWindow() {
 
 void SeVulkanWindow::init() {
     createSurface();
-    m_best_physical_device = m_vulkan_manager->getBestDevice(m_surface, m_device_extensions);
-    createLogicalDevice();
+    if (!acquireDeviceContext()) {
+        // Without a device the window stays empty, frames are skipped while
+        // there is no swap chain
+        destroySurface();
+        return;
+    }
+    m_swap_chain_tuner.setDevice(m_best_physical_device);
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(m_best_physical_device, &device_properties);
+    m_descriptor_allocator.init(m_logical_device, m_device_context->descriptorLayoutCache(), MAX_FRAMES_IN_FLIGHT);
+    m_uniform_ring.init(m_logical_device, m_device_context->memoryAllocator(), m_device_context->descriptorLayoutCache(), &m_descriptor_allocator, device_properties.limits.minUniformBufferOffsetAlignment,
+                        MAX_FRAMES_IN_FLIGHT, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, m_device_context->getBufferDeviceAddress());
+    // Evictions run in any window's frame, this one may not draw for a while
+    m_deletion_queue.setCompletionQuery([this]() { return pollCompletedFrames(); });
+    m_texture_loader.init(m_logical_device, m_best_physical_device, m_device_context->memoryAllocator(), m_device_context->uploadRing(), m_device_context->residencyManager(),
+                          &m_state_tracker, &m_deletion_queue, QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures");
+    if (m_bindless && m_device_context->isDescriptorIndexingSupported()) {
+        m_bindless_table.init(m_logical_device, m_device_context->descriptorLayoutCache(), &m_deletion_queue, m_device_context->descriptorIndexingProperties());
+    }
+    m_start_time = std::chrono::steady_clock::now();
+    m_last_frame_time = 0.0;
     createSwapChain();
     createImageViews();
     createRenderPass();
     createGraphicsPipeline();
+    createFramebuffers();
+    if (m_dynamic_rendering_supported) {
+        m_render_graph.init(m_logical_device, m_device_context->memoryAllocator(), m_device_context->descriptorLayoutCache(), &m_descriptor_allocator, m_vkCmdBeginRendering, m_vkCmdEndRendering, &m_state_tracker, &m_deletion_queue);
+        buildRenderGraph();
+    }
+    createCommandPools();
+    createCommandBuffers();
+    m_parallel_recorder.init(m_logical_device, m_queue_family_indices.graphic_family.value(), MAX_FRAMES_IN_FLIGHT);
+    createSyncObjects();
+    createRenderFinishedSemaphores();
+    createTimestampQueries();
 }
 
 void SeVulkanWindow::cleanup() {
+    if (m_logical_device) {
+        vkDeviceWaitIdle(m_logical_device);
+    }
+    m_deletion_queue.flush();
+    m_texture_loader.cleanup();
+    for (uint32_t i = 0; i < MAX_CHANNELS; i++) {
+        // The paths stay, so the channels can be loaded again
+        ChannelSource &source = m_channel_sources[i];
+        if (source.slot != SeBindlessTable::INVALID_HANDLE && m_channels[i] == source.slot) {
+            m_channels[i] = SeBindlessTable::INVALID_HANDLE;
+        }
+        source.pending_texture = SeTextureLoader::INVALID_TEXTURE;
+        source.bound_texture = SeTextureLoader::INVALID_TEXTURE;
+        source.slot = SeBindlessTable::INVALID_HANDLE;
+    }
+    m_channel_load_timing = false;
+    m_render_graph.cleanup();
+    m_state_tracker.clear();
+    destroyTimestampQueries();
+    destroyRenderFinishedSemaphores();
+    destroySyncObjects();
+    m_parallel_recorder.cleanup();
+    destroyCommandPools();
+    destroyFramebuffers();
     destroyGraphicsPipeline();
     destroyRenderPass();
     destoryImageViews();
     destroySwapChain();
-    destoryLogicalDevice();
+    m_bindless_table.cleanup();
+    m_uniform_ring.cleanup();
+    m_descriptor_allocator.cleanup();
+    releaseDeviceContext();
     m_best_physical_device = VK_NULL_HANDLE;
     destroySurface();
 }
 
+bool SeVulkanWindow::hasDevice() const {
+    return m_device_context != nullptr;
+}
+
 #pragma endregion Init and cleanup
 
 #pragma region Window surface
@@ -66,52 +133,57 @@ void SeVulkanWindow::destroySurface() {
 #pragma endregion Window surface
 
 #pragma region Logical device
-void SeVulkanWindow::createLogicalDevice() {
-    assert(m_best_physical_device != VK_NULL_HANDLE);
-
-    SeQueueFamilyIndices queue_family_indices = m_vulkan_manager->findQueueFamilies(m_best_physical_device, m_surface);
-
-    std::vector<VkDeviceQueueCreateInfo> device_queue_create_infos;
-    std::set<uint32_t> queue_families = {queue_family_indices.graphic_family.value(), queue_family_indices.present_family.value()};
-    float queue_priority = 1.0f;
-    for (auto queue_family : queue_families) {
-        VkDeviceQueueCreateInfo device_queue_create_info{};
-        device_queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        device_queue_create_info.queueCount = 1;
-        device_queue_create_info.queueFamilyIndex = queue_family_indices.graphic_family.value();
-        device_queue_create_info.pQueuePriorities = &queue_priority;
-        device_queue_create_info.pNext = nullptr;
-        device_queue_create_info.flags = 0;
-        device_queue_create_infos.push_back(device_queue_create_info);
-    }
-
-    VkDeviceCreateInfo device_create_info{};
-    device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    device_create_info.pQueueCreateInfos = device_queue_create_infos.data();
-    device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_families.size());
-    VkPhysicalDeviceFeatures device_features{};
-    device_create_info.pEnabledFeatures = &device_features;
-    device_create_info.enabledExtensionCount = static_cast<uint32_t>(m_device_extensions.size());
-    device_create_info.ppEnabledExtensionNames = m_device_extensions.data();
-    device_create_info.enabledLayerCount = 0;
-    VkResult result = vkCreateDevice(m_best_physical_device, &device_create_info, nullptr, &m_logical_device);
-    if (result == VK_SUCCESS) {
-        qDebug() << "Logical device created";
-    } else {
-        qDebug() << "Failed to create logical device!";
+bool SeVulkanWindow::acquireDeviceContext() {
+    // The first window creates the device for its surface, later ones share it
+    m_device_context = m_vulkan_manager->acquireDeviceContext(m_surface, this, [this]() {
+        if (m_device_lost) {
+            // This window saw the loss itself and is still inside its frame
+            return;
+        }
+        // Another window lost the shared device. Hidden windows may not get
+        // a frame for a long time, so the objects are released right away
+        // and the window recovers with its next frame
+        qDebug() << "Device lost by another window";
+        m_device_lost = true;
+        cleanup();
+        m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_ALL);
+        scheduleUpdate();
+    });
+    if (m_device_context == nullptr) {
+        qDebug() << "No device can present to the window, nothing will be rendered!";
+        return false;
     }
-    assert(result == VK_SUCCESS);
 
-    vkGetDeviceQueue(m_logical_device, queue_family_indices.graphic_family.value(), 0, &m_graphics_queue);
-    vkGetDeviceQueue(m_logical_device, queue_family_indices.present_family.value(), 0, &m_present_queue);
+    m_best_physical_device = m_device_context->physicalDevice();
+    m_logical_device = m_device_context->device();
+    m_queue_family_indices = m_device_context->queueFamilyIndices();
+    m_graphics_queue = m_device_context->graphicsQueue();
+    // Each window presents from the family that supports its own surface
+    SeQueueFamilyIndices surface_indices = m_vulkan_manager->findQueueFamilies(m_best_physical_device, m_surface);
+    m_queue_family_indices.present_family = surface_indices.present_family;
+    m_present_queue = m_device_context->queue(surface_indices.present_family.value());
+
+    m_present_timing_supported = m_device_context->isPresentTimingSupported();
+    m_vkWaitForPresentKHR = m_device_context->waitForPresent();
+    m_dynamic_rendering_supported = m_device_context->isDynamicRenderingSupported();
+    m_vkCmdBeginRendering = m_device_context->cmdBeginRendering();
+    m_vkCmdEndRendering = m_device_context->cmdEndRendering();
+    m_state_tracker.init(m_device_context->cmdPipelineBarrier2());
+    return true;
 }
 
-void SeVulkanWindow::destoryLogicalDevice() {
-    if (m_logical_device) {
-        vkDestroyDevice(m_logical_device, nullptr);
+void SeVulkanWindow::releaseDeviceContext() {
+    if (m_device_context) {
+        // The device itself goes away with its last window
+        m_vulkan_manager->releaseDeviceContext(this);
+        m_device_context = nullptr;
+        m_vkWaitForPresentKHR = nullptr;
+        m_vkCmdBeginRendering = nullptr;
+        m_vkCmdEndRendering = nullptr;
         m_graphics_queue = VK_NULL_HANDLE;
+        m_present_queue = VK_NULL_HANDLE;
         m_logical_device = VK_NULL_HANDLE;
-        qDebug() << "Logical device destoryed";
+        qDebug() << "Device context released";
     }
 }
 
@@ -164,10 +236,7 @@ void SeVulkanWindow::createSwapChain() {
     VkPresentModeKHR present_mode = chooseSwapPresentMode(details.present_modes);
     VkExtent2D extent = chooseSwapExtent(details.capabilities);
 
-    uint32_t image_count = details.capabilities.minImageCount + 1;
-    if (details.capabilities.maxImageCount > 0 && image_count > details.capabilities.maxImageCount) {
-        image_count = details.capabilities.maxImageCount;
-    }
+    uint32_t image_count = m_swap_chain_tuner.chooseImageCount(details.capabilities, present_mode);
 
     VkSwapchainCreateInfoKHR create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -178,6 +247,11 @@ void SeVulkanWindow::createSwapChain() {
     create_info.imageExtent = extent;
     create_info.imageArrayLayers = 1;
     create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    bool transfer_dst_supported = (details.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+    if (transfer_dst_supported) {
+        // Lets offscreen results be blitted straight into the swap chain
+        create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
 
     SeQueueFamilyIndices indices = m_vulkan_manager->findQueueFamilies(m_best_physical_device, m_surface);
     uint32_t queueFamilyIndices[] = {indices.graphic_family.value(), indices.present_family.value()};
@@ -196,32 +270,95 @@ void SeVulkanWindow::createSwapChain() {
     create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     create_info.presentMode = present_mode;
     create_info.clipped = VK_TRUE;
-    create_info.oldSwapchain = VK_NULL_HANDLE;
+    create_info.oldSwapchain = m_swap_chain;
 
     VkResult result;
     result = vkCreateSwapchainKHR(m_logical_device, &create_info, nullptr, &m_swap_chain);
     if (result == VK_SUCCESS) {
-        qDebug() << "Swap chain created";
+        qDebug() << "Swap chain created with" << image_count << "images, present mode" << present_mode;
     } else {
         qDebug() << "Failed to create swap chain!";
     }
     assert(result == VK_SUCCESS);
 
+    for (auto image : m_swap_chain_images) {
+        m_state_tracker.unregisterImage(image);
+    }
     vkGetSwapchainImagesKHR(m_logical_device, m_swap_chain, &image_count, nullptr);
     m_swap_chain_images.resize(image_count);
     vkGetSwapchainImagesKHR(m_logical_device, m_swap_chain, &image_count, m_swap_chain_images.data());
+    for (auto image : m_swap_chain_images) {
+        m_state_tracker.registerImage(image, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, VK_IMAGE_LAYOUT_UNDEFINED);
+    }
     m_swap_chain_image_format = surface_format.format;
     m_swap_chain_extent = extent;
+    m_swap_chain_present_mode = present_mode;
+    chooseAccumulationFormat(transfer_dst_supported);
+    checkDynamicResolutionSupport(transfer_dst_supported);
+
+    if (m_present_timing_supported) {
+        m_frame_pacer.start(m_logical_device, m_swap_chain, m_vkWaitForPresentKHR, &m_swap_chain_mutex);
+    }
 }
 
 void SeVulkanWindow::destroySwapChain() {
+    m_frame_pacer.stop();
     if (m_swap_chain) {
         vkDestroySwapchainKHR(m_logical_device, m_swap_chain, nullptr);
         m_swap_chain = VK_NULL_HANDLE;
+        for (auto image : m_swap_chain_images) {
+            m_state_tracker.unregisterImage(image);
+        }
+        m_swap_chain_images.clear();
         qDebug() << "Swap chain destroyed";
     }
 }
 
+void SeVulkanWindow::recreateSwapChain() {
+    if (QWindow::width() == 0 || QWindow::height() == 0) {
+        // Minimized, keep the old swap chain until the window is restored
+        m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+        return;
+    }
+
+    // The pacer waits on presents of the old swap chain
+    m_frame_pacer.stop();
+
+    VkDevice device = m_logical_device;
+    VkSwapchainKHR old_swap_chain = m_swap_chain;
+    VkFormat old_format = m_swap_chain_image_format;
+    std::vector<VkImageView> old_image_views = std::move(m_swap_chain_image_views);
+    std::vector<VkSemaphore> old_semaphores = std::move(m_render_finished_semaphores);
+    m_swap_chain_image_views.clear();
+    m_render_finished_semaphores.clear();
+    retireFramebuffers();
+
+    // The old swap chain is passed as oldSwapchain and destroyed together
+    // with its views once the frames that may still use it have completed
+    createSwapChain();
+    m_deletion_queue.retire(m_submitted_frame_number, [device, old_swap_chain, old_image_views, old_semaphores]() {
+        for (auto semaphore : old_semaphores) {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+        for (auto image_view : old_image_views) {
+            vkDestroyImageView(device, image_view, nullptr);
+        }
+        vkDestroySwapchainKHR(device, old_swap_chain, nullptr);
+        qDebug() << "Retired swap chain destroyed";
+    });
+
+    createImageViews();
+    if (m_swap_chain_image_format != old_format) {
+        replaceGraphicsPipeline(true);
+        if (m_dynamic_rendering_supported) {
+            // The scaled target is created in the swap chain format
+            buildRenderGraph();
+        }
+    }
+    createFramebuffers();
+    createRenderFinishedSemaphores();
+}
+
 #pragma endregion Swap chain
 
 #pragma region Image views
@@ -255,16 +392,24 @@ void SeVulkanWindow::createImageViews() {
 }
 
 void SeVulkanWindow::destoryImageViews() {
-    for (size_t i = 0; i < m_swap_chain_images.size(); i++) {
+    for (size_t i = 0; i < m_swap_chain_image_views.size(); i++) {
         vkDestroyImageView(m_logical_device, m_swap_chain_image_views[i], nullptr);
         qDebug() << "Image view " << i << " destroyed";
     }
+    m_swap_chain_image_views.clear();
 }
 
 #pragma endregion Image views
 
 #pragma region Render pass
 void SeVulkanWindow::createRenderPass() {
+    if (m_dynamic_rendering_supported) {
+        // Pipelines and command buffers target the image views directly
+        return;
+    }
+
+    bool multisampled = m_sample_count != VK_SAMPLE_COUNT_1_BIT;
+    std::vector<VkAttachmentDescription> attachments;
     VkAttachmentDescription color_attachment{};
     color_attachment.format = m_swap_chain_image_format;
     color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -278,23 +423,55 @@ void SeVulkanWindow::createRenderPass() {
     VkAttachmentReference color_attachment_ref{};
     color_attachment_ref.attachment = 0;
     color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    VkAttachmentReference resolve_attachment_ref{};
+    resolve_attachment_ref.attachment = 1;
+    resolve_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    if (multisampled) {
+        // The samples live and die inside the pass: they are cleared on
+        // load, resolved into the swap chain image at the end of the
+        // subpass and never stored, so a tiler keeps them in tile memory
+        VkAttachmentDescription msaa_attachment = color_attachment;
+        msaa_attachment.samples = m_sample_count;
+        msaa_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        msaa_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments.push_back(msaa_attachment);
+        // Every pixel of the swap chain image is written by the resolve
+        color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    }
+    attachments.push_back(color_attachment);
 
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &color_attachment_ref;
+    subpass.pResolveAttachments = multisampled ? &resolve_attachment_ref : nullptr;
+
+    // The layout transition has to wait for the acquire semaphore, which is
+    // waited on at the color attachment output stage. The multisampled
+    // target is shared by the frames in flight, so the previous frame's
+    // writes to it have to finish first as well
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = multisampled ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
     VkRenderPassCreateInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    render_pass_info.attachmentCount = 1;
-    render_pass_info.pAttachments = &color_attachment;
+    render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+    render_pass_info.pAttachments = attachments.data();
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &subpass;
+    render_pass_info.dependencyCount = 1;
+    render_pass_info.pDependencies = &dependency;
 
     VkResult result;
     result = vkCreateRenderPass(m_logical_device, &render_pass_info, nullptr, &m_render_pass);
     if (result == VK_SUCCESS) {
-        qDebug() << "Render pass created";
+        qDebug() << "Render pass created with" << m_sample_count << "samples";
     } else {
         qDebug() << "Failed to create render pass!";
     }
@@ -313,11 +490,21 @@ void SeVulkanWindow::destroyRenderPass() {
 
 #pragma region Graphics pipeline
 void SeVulkanWindow::createGraphicsPipeline() {
+    // The bindless variant samples set 1, which only this layout has, and the
+    // block variant needs buffer device address
+    bool bindless = m_bindless && m_bindless_table.isInitialized();
+    std::string frag_shader_path = std::string("Shader/Frag") + (bindless ? "Bindless" : "") + (m_uniform_ring.supportsBlocks() ? "Block" : "") + ".spv";
     auto vert_shader_code = SeUtil::readFile("Shader/Vert.spv");
-    auto frag_shader_code = SeUtil::readFile("Shader/Frag.spv");
+    auto frag_shader_code = SeUtil::readFile(frag_shader_path);
     m_vert_shader_module = createShaderModule(vert_shader_code);
     m_frag_shader_module = createShaderModule(frag_shader_code);
     qDebug() << "Shader modules created";
+    // Shaders reading time, time_delta or frame animate on their own and
+    // are rendered continuously, everything else only when marked dirty
+    const std::vector<uint32_t> time_members = {2, 3, 4};
+    m_shader_time_dependent = SeUtil::readsBlockMembers(vert_shader_code, 0, 0, time_members) || SeUtil::readsBlockMembers(frag_shader_code, 0, 0, time_members);
+    m_render_scheduler.setTimeDependent(m_time_dependent || m_shader_time_dependent);
+    qDebug() << "Shader is" << (m_shader_time_dependent ? "time dependent" : "static");
     VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
     vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -383,7 +570,7 @@ void SeVulkanWindow::createGraphicsPipeline() {
     VkPipelineMultisampleStateCreateInfo multisampling{};
     multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.rasterizationSamples = m_sample_count;
     multisampling.minSampleShading = 1.0f;          // Optional
     multisampling.pSampleMask = nullptr;            // Optional
     multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
@@ -410,12 +597,24 @@ void SeVulkanWindow::createGraphicsPipeline() {
     color_blending.blendConstants[2] = 0.0f; // Optional
     color_blending.blendConstants[3] = 0.0f; // Optional
 
+    // The sample index lets progressive shaders decorrelate their samples
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(PushConstants);
+
+    // Set 0 holds the frame uniforms, set 1 the bindless table if enabled
+    std::vector<VkDescriptorSetLayout> set_layouts = {m_uniform_ring.setLayout()};
+    if (bindless) {
+        set_layouts.push_back(m_bindless_table.setLayout());
+    }
+
     VkPipelineLayoutCreateInfo pipeline_layout_info{};
     pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_info.setLayoutCount = 0;            // Optional
-    pipeline_layout_info.pSetLayouts = nullptr;         // Optional
-    pipeline_layout_info.pushConstantRangeCount = 0;    // Optional
-    pipeline_layout_info.pPushConstantRanges = nullptr; // Optional
+    pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_info.pSetLayouts = set_layouts.data();
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
 
     VkResult result;
     result = vkCreatePipelineLayout(m_logical_device, &pipeline_layout_info, nullptr, &m_pipeline_layout);
@@ -426,8 +625,14 @@ void SeVulkanWindow::createGraphicsPipeline() {
     }
     assert(result == VK_SUCCESS);
 
+    VkPipelineRenderingCreateInfoKHR rendering_info{};
+    rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    rendering_info.colorAttachmentCount = 1;
+    rendering_info.pColorAttachmentFormats = &m_swap_chain_image_format;
+
     VkGraphicsPipelineCreateInfo pipeline_info{};
     pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_info.pNext = m_dynamic_rendering_supported ? &rendering_info : nullptr;
     pipeline_info.stageCount = 2;
     pipeline_info.pStages = shader_stages;
     pipeline_info.pVertexInputState = &vertex_input_info;
@@ -439,18 +644,87 @@ void SeVulkanWindow::createGraphicsPipeline() {
     pipeline_info.pColorBlendState = &color_blending;
     pipeline_info.pDynamicState = &dynamic_state;
     pipeline_info.layout = m_pipeline_layout;
-    pipeline_info.renderPass = m_render_pass;
+    pipeline_info.renderPass = m_render_pass; // VK_NULL_HANDLE with dynamic rendering
     pipeline_info.subpass = 0;
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipeline_info.basePipelineIndex = -1;              // Optional
 
-    result = vkCreateGraphicsPipelines(m_logical_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_graphics_pipeline);
+    result = vkCreateGraphicsPipelines(m_logical_device, m_device_context->pipelineCache(), 1, &pipeline_info, nullptr, &m_graphics_pipeline);
     if (result == VK_SUCCESS) {
         qDebug() << "Pipeline created";
     } else {
         qDebug() << "Failed to create pipeline";
     }
     assert(result == VK_SUCCESS);
+
+    if (m_accumulation_format == VK_FORMAT_UNDEFINED) {
+        return;
+    }
+
+    // Accumulation variant: blends each sample into the running average,
+    // dst = src * w + dst * (1 - w) with w = 1 / (n + 1) as blend constant
+    color_blend_attachment.blendEnable = VK_TRUE;
+    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_CONSTANT_COLOR;
+    color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_COLOR;
+    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_CONSTANT_ALPHA;
+    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_ALPHA;
+    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    dynamic_states.push_back(VK_DYNAMIC_STATE_BLEND_CONSTANTS);
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+    dynamic_state.pDynamicStates = dynamic_states.data();
+    rendering_info.pColorAttachmentFormats = &m_accumulation_format;
+    // Accumulation already averages samples over time, the tiles it draws
+    // stay single sampled
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    result = vkCreateGraphicsPipelines(m_logical_device, m_device_context->pipelineCache(), 1, &pipeline_info, nullptr, &m_accumulation_pipeline);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Accumulation pipeline created";
+    } else {
+        qDebug() << "Failed to create accumulation pipeline";
+    }
+    assert(result == VK_SUCCESS);
+}
+
+void SeVulkanWindow::replaceGraphicsPipeline(bool replace_render_pass) {
+    VkDevice device = m_logical_device;
+    VkRenderPass old_render_pass = replace_render_pass ? m_render_pass : VK_NULL_HANDLE;
+    VkPipeline old_pipeline = m_graphics_pipeline;
+    VkPipeline old_accumulation_pipeline = m_accumulation_pipeline;
+    VkPipelineLayout old_pipeline_layout = m_pipeline_layout;
+    VkShaderModule old_vert_shader_module = m_vert_shader_module;
+    VkShaderModule old_frag_shader_module = m_frag_shader_module;
+    m_graphics_pipeline = VK_NULL_HANDLE;
+    m_accumulation_pipeline = VK_NULL_HANDLE;
+    m_pipeline_layout = VK_NULL_HANDLE;
+    m_vert_shader_module = VK_NULL_HANDLE;
+    m_frag_shader_module = VK_NULL_HANDLE;
+    if (replace_render_pass) {
+        m_render_pass = VK_NULL_HANDLE;
+        createRenderPass();
+    }
+    createGraphicsPipeline();
+
+    // Frames in flight keep using the old pipeline until they complete
+    m_deletion_queue.retire(m_submitted_frame_number, [device, old_render_pass, old_pipeline, old_accumulation_pipeline, old_pipeline_layout, old_vert_shader_module, old_frag_shader_module]() {
+        vkDestroyPipeline(device, old_pipeline, nullptr);
+        if (old_accumulation_pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, old_accumulation_pipeline, nullptr);
+        }
+        vkDestroyPipelineLayout(device, old_pipeline_layout, nullptr);
+        vkDestroyShaderModule(device, old_frag_shader_module, nullptr);
+        vkDestroyShaderModule(device, old_vert_shader_module, nullptr);
+        if (old_render_pass != VK_NULL_HANDLE) {
+            vkDestroyRenderPass(device, old_render_pass, nullptr);
+        }
+        qDebug() << "Retired pipeline destroyed";
+    });
+}
+
+void SeVulkanWindow::reloadShaders() {
+    replaceGraphicsPipeline(false);
+    markShaderChanged();
 }
 
 void SeVulkanWindow::destroyGraphicsPipeline() {
@@ -458,6 +732,10 @@ void SeVulkanWindow::destroyGraphicsPipeline() {
         vkDestroyPipeline(m_logical_device, m_graphics_pipeline, nullptr);
         m_graphics_pipeline = VK_NULL_HANDLE;
     }
+    if (m_accumulation_pipeline) {
+        vkDestroyPipeline(m_logical_device, m_accumulation_pipeline, nullptr);
+        m_accumulation_pipeline = VK_NULL_HANDLE;
+    }
     qDebug() << "Pipeline destroyed";
     if (m_pipeline_layout) {
         vkDestroyPipelineLayout(m_logical_device, m_pipeline_layout, nullptr);
@@ -492,4 +770,1385 @@ VkShaderModule SeVulkanWindow::createShaderModule(std::vector<char> code) {
     return shader_module;
 }
 
-#pragma endregion Graphics pipeline
\ No newline at end of file
+#pragma endregion Graphics pipeline
+#pragma region Framebuffers
+void SeVulkanWindow::createFramebuffers() {
+    // One multisampled target serves every swap chain image, the render
+    // pass or the state tracker orders the frames' writes to it
+    if (m_sample_count != VK_SAMPLE_COUNT_1_BIT) {
+        createTransientAttachment(m_swap_chain_image_format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT, m_msaa_attachment);
+    }
+    if (m_dynamic_rendering_supported) {
+        // The render graph resolves it into the image pass output
+        return;
+    }
+
+    m_swap_chain_framebuffers.resize(m_swap_chain_image_views.size());
+    for (size_t i = 0; i < m_swap_chain_image_views.size(); i++) {
+        std::vector<VkImageView> attachments;
+        if (m_msaa_attachment.view != VK_NULL_HANDLE) {
+            attachments.push_back(m_msaa_attachment.view);
+        }
+        attachments.push_back(m_swap_chain_image_views[i]);
+
+        VkFramebufferCreateInfo framebuffer_info{};
+        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_info.renderPass = m_render_pass;
+        framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebuffer_info.pAttachments = attachments.data();
+        framebuffer_info.width = m_swap_chain_extent.width;
+        framebuffer_info.height = m_swap_chain_extent.height;
+        framebuffer_info.layers = 1;
+
+        VkResult result;
+        result = vkCreateFramebuffer(m_logical_device, &framebuffer_info, nullptr, &m_swap_chain_framebuffers[i]);
+        if (result == VK_SUCCESS) {
+            qDebug() << "Framebuffer " << i << " created";
+        } else {
+            qDebug() << "Failed to create framebuffer " << i << "!";
+        }
+        assert(result == VK_SUCCESS);
+    }
+}
+
+void SeVulkanWindow::destroyFramebuffers() {
+    for (size_t i = 0; i < m_swap_chain_framebuffers.size(); i++) {
+        vkDestroyFramebuffer(m_logical_device, m_swap_chain_framebuffers[i], nullptr);
+        qDebug() << "Framebuffer " << i << " destroyed";
+    }
+    m_swap_chain_framebuffers.clear();
+    destroyTransientAttachment(m_msaa_attachment);
+}
+
+void SeVulkanWindow::retireFramebuffers() {
+    // Frames in flight may still render into the old framebuffers
+    VkDevice device = m_logical_device;
+    SeMemoryAllocator *memory_allocator = m_device_context->memoryAllocator();
+    std::vector<VkFramebuffer> old_framebuffers = std::move(m_swap_chain_framebuffers);
+    TransientAttachment old_msaa_attachment = m_msaa_attachment;
+    m_swap_chain_framebuffers.clear();
+    m_state_tracker.unregisterImage(m_msaa_attachment.image);
+    m_msaa_attachment = TransientAttachment{};
+    m_deletion_queue.retire(m_submitted_frame_number, [device, memory_allocator, old_framebuffers, old_msaa_attachment]() mutable {
+        for (auto framebuffer : old_framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        if (old_msaa_attachment.image != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, old_msaa_attachment.view, nullptr);
+            memory_allocator->destroyImage(old_msaa_attachment.image, old_msaa_attachment.allocation);
+        }
+    });
+}
+
+void SeVulkanWindow::createTransientAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, TransientAttachment &attachment) {
+    // Only ever written and read inside a render pass, so tilers can keep
+    // the contents on chip and back the image with lazily allocated memory
+    // that is never committed
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = format;
+    image_info.extent = {m_swap_chain_extent.width, m_swap_chain_extent.height, 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = m_sample_count;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    SeMemoryAllocator *memory_allocator = m_device_context->memoryAllocator();
+    bool lazily_allocated = memory_allocator->findMemoryType(UINT32_MAX, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != UINT32_MAX;
+    VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    if (lazily_allocated) {
+        result = memory_allocator->createImage(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, attachment.image, attachment.allocation);
+        lazily_allocated = result == VK_SUCCESS;
+    }
+    if (!lazily_allocated) {
+        result = memory_allocator->createImage(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, attachment.image, attachment.allocation);
+    }
+    if (result == VK_SUCCESS) {
+        qDebug() << "Transient attachment created in" << (lazily_allocated ? "lazily allocated" : "device local") << "memory," << attachment.allocation.size / 1024 << "KiB";
+    } else {
+        qDebug() << "Failed to create transient attachment!";
+    }
+    assert(result == VK_SUCCESS);
+
+    VkImageViewCreateInfo view_info{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = attachment.image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = aspect;
+    view_info.subresourceRange.baseMipLevel = 0;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.baseArrayLayer = 0;
+    view_info.subresourceRange.layerCount = 1;
+    result = vkCreateImageView(m_logical_device, &view_info, nullptr, &attachment.view);
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to create transient attachment view!";
+    }
+    assert(result == VK_SUCCESS);
+    m_state_tracker.registerImage(attachment.image, aspect, 1, 1, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+void SeVulkanWindow::destroyTransientAttachment(TransientAttachment &attachment) {
+    if (attachment.image != VK_NULL_HANDLE) {
+        m_state_tracker.unregisterImage(attachment.image);
+        vkDestroyImageView(m_logical_device, attachment.view, nullptr);
+        m_device_context->memoryAllocator()->destroyImage(attachment.image, attachment.allocation);
+        attachment = TransientAttachment{};
+    }
+}
+
+#pragma endregion Framebuffers
+
+#pragma region Command buffers
+void SeVulkanWindow::createCommandPools() {
+    // One transient pool per frame in flight, reset wholesale once the
+    // frame's fence has signaled instead of resetting buffers one by one
+    m_command_pools.resize(MAX_FRAMES_IN_FLIGHT);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkCommandPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        pool_info.queueFamilyIndex = m_queue_family_indices.graphic_family.value();
+
+        VkResult result;
+        result = vkCreateCommandPool(m_logical_device, &pool_info, nullptr, &m_command_pools[i]);
+        if (result == VK_SUCCESS) {
+            qDebug() << "Command pool for frame " << i << " created";
+        } else {
+            qDebug() << "Failed to create command pool for frame " << i << "!";
+        }
+        assert(result == VK_SUCCESS);
+    }
+}
+
+void SeVulkanWindow::destroyCommandPools() {
+    for (auto command_pool : m_command_pools) {
+        vkDestroyCommandPool(m_logical_device, command_pool, nullptr);
+    }
+    if (!m_command_pools.empty()) {
+        qDebug() << "Command pools destroyed";
+    }
+    m_command_pools.clear();
+    m_command_buffers.clear();
+}
+
+void SeVulkanWindow::createCommandBuffers() {
+    m_command_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = m_command_pools[i];
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = 1;
+
+        VkResult result;
+        result = vkAllocateCommandBuffers(m_logical_device, &alloc_info, &m_command_buffers[i]);
+        if (result == VK_SUCCESS) {
+            qDebug() << "Command buffer for frame " << i << " allocated";
+        } else {
+            qDebug() << "Failed to allocate command buffer for frame " << i << "!";
+        }
+        assert(result == VK_SUCCESS);
+    }
+}
+
+void SeVulkanWindow::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index) {
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult result;
+    result = vkBeginCommandBuffer(command_buffer, &begin_info);
+    assert(result == VK_SUCCESS);
+
+    m_device_context->uploadRing()->recordAcquireBarriers(command_buffer);
+    std::vector<SeTextureLoader::TextureHandle> ready_textures = m_texture_loader.recordMipGeneration(command_buffer, m_submitted_frame_number + 1);
+    if (!ready_textures.empty()) {
+        bindLoadedChannels(ready_textures);
+    }
+
+    if (m_dynamic_rendering_supported) {
+        recordRenderGraph(command_buffer, image_index);
+    } else {
+        beginRendering(command_buffer, image_index, m_parallel_recording);
+        if (m_parallel_recording) {
+            // One task per pass or preview pane, stitched back in task order
+            std::vector<SeParallelRecorder::RecordFunction> tasks = {
+                [this](VkCommandBuffer secondary_command_buffer) { recordPreview(secondary_command_buffer, m_graphics_pipeline, m_swap_chain_extent); }};
+
+            VkCommandBufferInheritanceRenderingInfoKHR rendering_inheritance{};
+            VkCommandBufferInheritanceInfo inheritance = renderingInheritanceInfo(rendering_inheritance, image_index);
+            std::vector<VkCommandBuffer> secondary_command_buffers = m_parallel_recorder.record(
+                inheritance, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, tasks);
+            vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondary_command_buffers.size()), secondary_command_buffers.data());
+        } else {
+            recordPreview(command_buffer, m_graphics_pipeline, m_swap_chain_extent);
+        }
+        endRendering(command_buffer);
+    }
+
+    result = vkEndCommandBuffer(command_buffer);
+    assert(result == VK_SUCCESS);
+}
+
+void SeVulkanWindow::recordPreview(VkCommandBuffer command_buffer, VkPipeline pipeline, VkExtent2D extent) const {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    bindFrameResources(command_buffer);
+
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+}
+
+VkCommandBufferInheritanceInfo SeVulkanWindow::renderingInheritanceInfo(VkCommandBufferInheritanceRenderingInfoKHR &rendering_inheritance, uint32_t image_index) const {
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    if (m_dynamic_rendering_supported) {
+        rendering_inheritance = {};
+        rendering_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+        rendering_inheritance.colorAttachmentCount = 1;
+        rendering_inheritance.pColorAttachmentFormats = &m_swap_chain_image_format;
+        rendering_inheritance.rasterizationSamples = m_sample_count;
+        inheritance.pNext = &rendering_inheritance;
+    } else {
+        inheritance.renderPass = m_render_pass;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = m_swap_chain_framebuffers[image_index];
+    }
+    return inheritance;
+}
+
+void SeVulkanWindow::beginRendering(VkCommandBuffer command_buffer, uint32_t image_index, bool secondary_contents) {
+    // Render pass path for devices without dynamic rendering, which draw
+    // the image pass straight into the swap chain without a render graph
+    // The resolve target is never cleared, its clear value is ignored
+    VkClearValue clear_values[2] = {{{{0.0f, 0.0f, 0.0f, 1.0f}}}, {{{0.0f, 0.0f, 0.0f, 1.0f}}}};
+    VkRenderPassBeginInfo render_pass_info{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_info.renderPass = m_render_pass;
+    render_pass_info.framebuffer = m_swap_chain_framebuffers[image_index];
+    render_pass_info.renderArea.offset = {0, 0};
+    render_pass_info.renderArea.extent = m_swap_chain_extent;
+    render_pass_info.clearValueCount = m_sample_count != VK_SAMPLE_COUNT_1_BIT ? 2 : 1;
+    render_pass_info.pClearValues = clear_values;
+    vkCmdBeginRenderPass(command_buffer, &render_pass_info, secondary_contents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void SeVulkanWindow::endRendering(VkCommandBuffer command_buffer) {
+    vkCmdEndRenderPass(command_buffer);
+}
+
+#pragma endregion Command buffers
+
+#pragma region Render graph
+void SeVulkanWindow::buildRenderGraph() {
+    // Buffer passes of a shader project are declared ahead of the image pass
+    // and read through the pass context's input set
+    m_render_graph.clear();
+    m_backbuffer_resource = m_render_graph.importImage("Backbuffer", m_swap_chain_image_format);
+    m_accumulation_resource = SeRenderGraph::INVALID_RESOURCE;
+    m_scaled_resource = SeRenderGraph::INVALID_RESOURCE;
+    m_image_pass = SeRenderGraph::INVALID_PASS;
+    if (m_progressive_accumulation || m_tiled_rendering) {
+        // The image pass draws this frame's tiles into the history image,
+        // which is blitted to the swap chain after the graph has executed.
+        // Accumulation blends a sample into it with every completed sweep,
+        // so it is never multisampled
+        m_accumulation_resource = m_render_graph.createHistoryImage("Accumulation", m_accumulation_format);
+        SeRenderGraph::PassHandle pass = m_render_graph.addPass("Image", {}, {m_accumulation_resource}, [this](VkCommandBuffer command_buffer, const SeRenderGraph::PassContext &context) {
+            Q_UNUSED(context);
+            recordTiles(command_buffer);
+        });
+        // An empty batch means the accumulation has converged, after one
+        // more run the pass is skipped and only the blit is left
+        m_render_graph.setPassCacheKey(pass, [this]() -> uint64_t {
+            return m_tile_batch.tile_count > 0 ? 0 : SeRenderGraph::hashCombine(MAX_ACCUMULATED_SAMPLES, (uint64_t)m_accumulation_pipeline);
+        });
+        m_render_graph.markOutput(m_accumulation_resource);
+    } else if (m_dynamic_resolution) {
+        // The target keeps the swap chain size and the image pass only
+        // covers its top left corner, so a new scale never reallocates it.
+        // The corner is stretched over the swap chain after the graph
+        m_scaled_resource = m_render_graph.createImage("Scaled", m_swap_chain_image_format, 1.0f, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        m_image_pass = m_render_graph.addPass("Image", {}, {m_scaled_resource}, [this](VkCommandBuffer command_buffer, const SeRenderGraph::PassContext &context) {
+            Q_UNUSED(context);
+            recordPreview(command_buffer, m_graphics_pipeline, m_render_extent);
+        });
+        m_render_graph.markOutput(m_scaled_resource);
+    } else {
+        m_image_pass = m_render_graph.addPass("Image", {}, {m_backbuffer_resource}, [this](VkCommandBuffer command_buffer, const SeRenderGraph::PassContext &context) {
+            Q_UNUSED(context);
+            recordPreview(command_buffer, m_graphics_pipeline, m_swap_chain_extent);
+        });
+        m_render_graph.markOutput(m_backbuffer_resource);
+    }
+    updateTitle();
+}
+
+void SeVulkanWindow::recordRenderGraph(VkCommandBuffer command_buffer, uint32_t image_index) {
+    // Acquire hands the image over with undefined contents once the
+    // semaphore wait at the color attachment output stage has completed
+    VkImage image = m_swap_chain_images[image_index];
+    m_state_tracker.resetImage(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE);
+
+    bool history_rendering = m_accumulation_resource != SeRenderGraph::INVALID_RESOURCE;
+    if (history_rendering) {
+        m_tile_scheduler.setExtent(m_swap_chain_extent);
+        bool converged = m_progressive_accumulation && m_accumulated_samples >= MAX_ACCUMULATED_SAMPLES;
+        m_tile_batch = converged ? SeTileScheduler::Batch{} : m_tile_scheduler.nextBatch();
+    }
+    bool scaled_rendering = m_scaled_resource != SeRenderGraph::INVALID_RESOURCE;
+    if (scaled_rendering) {
+        m_render_extent = m_resolution_scaler.scaledExtent(m_swap_chain_extent);
+    }
+
+    // Only a topology, extent or format change recompiles the graph
+    m_render_graph.setExtent(m_swap_chain_extent);
+    m_render_graph.setImportedImage(m_backbuffer_resource, image, m_swap_chain_image_views[image_index], m_swap_chain_image_format);
+    if (m_image_pass != SeRenderGraph::INVALID_PASS) {
+        VkSampleCountFlagBits samples = m_msaa_attachment.image != VK_NULL_HANDLE ? m_sample_count : VK_SAMPLE_COUNT_1_BIT;
+        m_render_graph.setPassMultisampleTarget(m_image_pass, m_msaa_attachment.image, m_msaa_attachment.view, samples);
+    }
+    m_render_graph.compile(m_submitted_frame_number);
+
+    // Every frame that draws is timed, a frame without history counts as
+    // a single tile
+    uint32_t drawn_tiles = history_rendering ? m_tile_batch.tile_count : 1;
+    bool timed = drawn_tiles > 0 && m_timestamp_query_pool != VK_NULL_HANDLE;
+    if (timed) {
+        vkCmdResetQueryPool(command_buffer, m_timestamp_query_pool, m_current_frame * 2, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestamp_query_pool, m_current_frame * 2);
+    }
+    m_render_graph.execute(command_buffer, m_parallel_recording ? &m_parallel_recorder : nullptr);
+    if (timed) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_query_pool, m_current_frame * 2 + 1);
+    }
+    m_frame_timed_tiles[m_current_frame] = timed ? drawn_tiles : 0;
+
+    if (history_rendering) {
+        if (m_progressive_accumulation && m_tile_batch.completes_sweep) {
+            m_accumulated_samples++;
+            if (m_accumulated_samples == MAX_ACCUMULATED_SAMPLES) {
+                qDebug() << "Accumulation converged after" << m_accumulated_samples << "samples";
+            }
+        }
+        blitToSwapChain(command_buffer, m_render_graph.image(m_accumulation_resource), m_swap_chain_extent, image, VK_FILTER_NEAREST);
+    } else if (scaled_rendering) {
+        blitToSwapChain(command_buffer, m_render_graph.image(m_scaled_resource), m_render_extent, image, VK_FILTER_LINEAR);
+    }
+
+    m_state_tracker.requireImage(image, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
+    m_state_tracker.flush(command_buffer);
+}
+
+void SeVulkanWindow::bindFrameResources(VkCommandBuffer command_buffer) const {
+    // In bindless mode every pass binds the same two sets and only the
+    // channel handles in the push constants select what it samples
+    VkDescriptorSet descriptor_sets[] = {m_uniform_ring.descriptorSet(), m_bindless_table.descriptorSet()};
+    uint32_t set_count = m_bindless && m_bindless_table.isInitialized() ? 2 : 1;
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, set_count, descriptor_sets, 1, &m_frame_uniform_offset);
+    if (set_count == 2) {
+        vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, offsetof(PushConstants, channels), sizeof(m_channels), m_channels);
+    }
+    if (m_uniform_ring.supportsBlocks()) {
+        vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, offsetof(PushConstants, parameters), sizeof(VkDeviceAddress), &m_parameter_address);
+    }
+}
+
+void SeVulkanWindow::recordTiles(VkCommandBuffer command_buffer) const {
+    // Without accumulation the weight is 1 and tiles simply overwrite
+    float weight = m_progressive_accumulation ? 1.0f / static_cast<float>(m_accumulated_samples + 1) : 1.0f;
+    float blend_constants[4] = {weight, weight, weight, weight};
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_accumulation_pipeline);
+    bindFrameResources(command_buffer);
+    vkCmdSetBlendConstants(command_buffer, blend_constants);
+    vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, offsetof(PushConstants, accumulated_samples), sizeof(uint32_t), &m_accumulated_samples);
+
+    // The viewport always spans the whole image so fragment coordinates do
+    // not depend on the tiling, only the scissor moves
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)m_swap_chain_extent.width;
+    viewport.height = (float)m_swap_chain_extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    for (uint32_t i = 0; i < m_tile_batch.tile_count; i++) {
+        VkRect2D scissor = m_tile_scheduler.tileRect(m_tile_batch.first_tile + i);
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        vkCmdDraw(command_buffer, 3, 1, 0, 0);
+    }
+}
+
+void SeVulkanWindow::blitToSwapChain(VkCommandBuffer command_buffer, VkImage source_image, VkExtent2D source_extent, VkImage swap_chain_image, VkFilter filter) {
+    m_state_tracker.requireImage(source_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    m_state_tracker.requireImage(swap_chain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    m_state_tracker.flush(command_buffer);
+
+    // Converts to the swap chain format and, for a scaled source, stretches
+    // it over the whole swap chain
+    VkImageBlit region{};
+    region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.srcOffsets[1] = {static_cast<int32_t>(source_extent.width), static_cast<int32_t>(source_extent.height), 1};
+    region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.dstOffsets[1] = {static_cast<int32_t>(m_swap_chain_extent.width), static_cast<int32_t>(m_swap_chain_extent.height), 1};
+    vkCmdBlitImage(command_buffer, source_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swap_chain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, filter);
+}
+
+void SeVulkanWindow::chooseAccumulationFormat(bool transfer_dst_supported) {
+    // Prefer full float precision, half floats start to band after a few
+    // thousand samples
+    const VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT;
+    const VkFormat candidates[] = {VK_FORMAT_R32G32B32A32_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT};
+
+    VkFormatProperties swap_chain_properties;
+    vkGetPhysicalDeviceFormatProperties(m_best_physical_device, m_swap_chain_image_format, &swap_chain_properties);
+    bool blit_supported = transfer_dst_supported && (swap_chain_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+
+    VkFormat accumulation_format = VK_FORMAT_UNDEFINED;
+    if (m_dynamic_rendering_supported && blit_supported) {
+        for (auto candidate : candidates) {
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(m_best_physical_device, candidate, &properties);
+            if ((properties.optimalTilingFeatures & required_features) == required_features) {
+                accumulation_format = candidate;
+                break;
+            }
+        }
+    }
+
+    // The format only ever goes from undefined to a fixed choice, the
+    // pipeline is created once the swap chain exists
+    if (m_accumulation_format == VK_FORMAT_UNDEFINED) {
+        m_accumulation_format = accumulation_format;
+    }
+    m_accumulation_supported = accumulation_format != VK_FORMAT_UNDEFINED;
+    if ((m_progressive_accumulation || m_tiled_rendering) && !m_accumulation_supported) {
+        qDebug() << "Progressive accumulation and tiling no longer supported by the swap chain, disabled";
+        m_progressive_accumulation = false;
+        m_tiled_rendering = false;
+        m_tile_scheduler.setTiling(false);
+        buildRenderGraph();
+    }
+}
+
+void SeVulkanWindow::checkDynamicResolutionSupport(bool transfer_dst_supported) {
+    // The scaled target shares the swap chain format and is stretched with
+    // a linear filter
+    const VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_best_physical_device, m_swap_chain_image_format, &properties);
+    m_dynamic_resolution_supported =
+        m_dynamic_rendering_supported && transfer_dst_supported && (properties.optimalTilingFeatures & required_features) == required_features;
+    if (m_dynamic_resolution && !m_dynamic_resolution_supported) {
+        qDebug() << "Dynamic resolution no longer supported by the swap chain, disabled";
+        m_dynamic_resolution = false;
+        m_resolution_scaler.reset();
+        buildRenderGraph();
+    }
+}
+
+void SeVulkanWindow::resetAccumulation() {
+    // Tiling alone keeps the old image and overwrites it tile by tile
+    m_accumulated_samples = 0;
+    m_tile_scheduler.restart();
+    if (m_progressive_accumulation && m_accumulation_resource != SeRenderGraph::INVALID_RESOURCE) {
+        m_render_graph.discardHistory(m_accumulation_resource);
+    }
+}
+
+#pragma endregion Render graph
+
+#pragma region GPU timing
+void SeVulkanWindow::createTimestampQueries() {
+    m_frame_timed_tiles.assign(MAX_FRAMES_IN_FLIGHT, 0);
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(m_best_physical_device, &device_properties);
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_best_physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_best_physical_device, &queue_family_count, queue_families.data());
+    uint32_t valid_bits = queue_families[m_queue_family_indices.graphic_family.value()].timestampValidBits;
+    if (valid_bits == 0 || device_properties.limits.timestampPeriod <= 0.0f) {
+        qDebug() << "GPU timestamps not supported, tile budget stays fixed";
+        return;
+    }
+    m_timestamp_period = device_properties.limits.timestampPeriod;
+
+    // A begin and an end timestamp per frame in flight
+    VkQueryPoolCreateInfo query_pool_info{};
+    query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_info.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
+
+    VkResult result;
+    result = vkCreateQueryPool(m_logical_device, &query_pool_info, nullptr, &m_timestamp_query_pool);
+    if (result == VK_SUCCESS) {
+        qDebug() << "Timestamp query pool created";
+    } else {
+        qDebug() << "Failed to create timestamp query pool!";
+    }
+    assert(result == VK_SUCCESS);
+}
+
+void SeVulkanWindow::destroyTimestampQueries() {
+    if (m_timestamp_query_pool) {
+        vkDestroyQueryPool(m_logical_device, m_timestamp_query_pool, nullptr);
+        m_timestamp_query_pool = VK_NULL_HANDLE;
+    }
+    m_frame_timed_tiles.clear();
+}
+
+void SeVulkanWindow::readTimestamps(uint32_t frame_index) {
+    // Called after the frame's fence has signaled, so the results are ready
+    uint32_t tile_count = m_frame_timed_tiles[frame_index];
+    if (tile_count == 0) {
+        return;
+    }
+    m_frame_timed_tiles[frame_index] = 0;
+
+    uint64_t timestamps[2] = {0, 0};
+    VkResult result;
+    result = vkGetQueryPoolResults(m_logical_device, m_timestamp_query_pool, frame_index * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS || timestamps[1] < timestamps[0]) {
+        return;
+    }
+    double gpu_ms = static_cast<double>(timestamps[1] - timestamps[0]) * m_timestamp_period / 1000000.0;
+    m_tile_scheduler.recordGpuTime(tile_count, gpu_ms);
+    if (m_scaled_resource != SeRenderGraph::INVALID_RESOURCE && m_resolution_scaler.recordGpuTime(gpu_ms)) {
+        updateTitle();
+    }
+}
+
+#pragma endregion GPU timing
+
+#pragma region Synchronization
+void SeVulkanWindow::createSyncObjects() {
+    m_image_available_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    m_in_flight_fences.resize(MAX_FRAMES_IN_FLIGHT);
+    m_frame_numbers.assign(MAX_FRAMES_IN_FLIGHT, 0);
+
+    VkSemaphoreCreateInfo semaphore_info{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkResult result;
+        result = vkCreateSemaphore(m_logical_device, &semaphore_info, nullptr, &m_image_available_semaphores[i]);
+        if (result == VK_SUCCESS) {
+            result = vkCreateFence(m_logical_device, &fence_info, nullptr, &m_in_flight_fences[i]);
+        }
+        if (result == VK_SUCCESS) {
+            qDebug() << "Sync objects for frame " << i << " created";
+        } else {
+            qDebug() << "Failed to create sync objects for frame " << i << "!";
+        }
+        assert(result == VK_SUCCESS);
+    }
+}
+
+void SeVulkanWindow::destroySyncObjects() {
+    for (auto semaphore : m_image_available_semaphores) {
+        vkDestroySemaphore(m_logical_device, semaphore, nullptr);
+    }
+    for (auto fence : m_in_flight_fences) {
+        vkDestroyFence(m_logical_device, fence, nullptr);
+    }
+    m_image_available_semaphores.clear();
+    m_in_flight_fences.clear();
+    qDebug() << "Sync objects destroyed";
+}
+
+uint64_t SeVulkanWindow::pollCompletedFrames() {
+    // Fences are reset before the frame number of their next submission is
+    // stored, so a signaled fence always belongs to the stored frame
+    for (size_t i = 0; i < m_in_flight_fences.size(); i++) {
+        if (m_frame_numbers[i] > m_completed_frame_number && vkGetFenceStatus(m_logical_device, m_in_flight_fences[i]) == VK_SUCCESS) {
+            m_completed_frame_number = m_frame_numbers[i];
+        }
+    }
+    return m_completed_frame_number;
+}
+
+void SeVulkanWindow::createRenderFinishedSemaphores() {
+    // One per swap chain image: a semaphore waited on by present can only be
+    // reused once that image has been acquired again
+    m_render_finished_semaphores.resize(m_swap_chain_images.size());
+
+    VkSemaphoreCreateInfo semaphore_info{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for (size_t i = 0; i < m_render_finished_semaphores.size(); i++) {
+        VkResult result;
+        result = vkCreateSemaphore(m_logical_device, &semaphore_info, nullptr, &m_render_finished_semaphores[i]);
+        if (result != VK_SUCCESS) {
+            qDebug() << "Failed to create render finished semaphore " << i << "!";
+        }
+        assert(result == VK_SUCCESS);
+    }
+}
+
+void SeVulkanWindow::destroyRenderFinishedSemaphores() {
+    for (auto semaphore : m_render_finished_semaphores) {
+        vkDestroySemaphore(m_logical_device, semaphore, nullptr);
+    }
+    m_render_finished_semaphores.clear();
+}
+
+#pragma endregion Synchronization
+
+#pragma region Frame loop
+bool SeVulkanWindow::drawFrame() {
+    bool present_timing = m_frame_pacer.isRunning();
+    if (present_timing) {
+        m_frame_pacer.waitForFrameStart();
+    }
+
+    VkResult result;
+    result = vkWaitForFences(m_logical_device, 1, &m_in_flight_fences[m_current_frame], VK_TRUE, UINT64_MAX);
+    if (deviceLost(result)) {
+        return false;
+    }
+    // Frames complete in submission order, so every older frame is done too
+    m_completed_frame_number = std::max(m_completed_frame_number, m_frame_numbers[m_current_frame]);
+    m_deletion_queue.collect(m_completed_frame_number);
+    readTimestamps(m_current_frame);
+
+    // Finished decodes become uploads before the ring is pumped. Textures
+    // dropped here were last used by the latest submitted frame at most
+    m_texture_loader.update(m_submitted_frame_number, m_completed_frame_number);
+    // Over budget heaps give back cached textures before new ones arrive
+    m_device_context->residencyManager()->update(m_device_context->beginFrame(this));
+
+    // Streams pending uploads on the transfer queue, never waits for them
+    result = m_device_context->uploadRing()->pump();
+    if (deviceLost(result)) {
+        return false;
+    }
+
+    uint64_t present_id = m_frame_pacer.beginFrame();
+    uint32_t image_index = 0;
+    // The swap chain is externally synchronized with the pacer's present
+    // waits. Holding the lock across a blocking acquire would stamp their
+    // completion late, so the acquire waits in short slices instead
+    uint64_t acquire_timeout = present_timing ? ACQUIRE_SLICE_NS : UINT64_MAX;
+    do {
+        {
+            std::lock_guard<std::mutex> lock(m_swap_chain_mutex);
+            result = vkAcquireNextImageKHR(m_logical_device, m_swap_chain, acquire_timeout, m_image_available_semaphores[m_current_frame], VK_NULL_HANDLE, &image_index);
+        }
+        if (result == VK_TIMEOUT) {
+            std::this_thread::yield();
+        }
+    } while (result == VK_TIMEOUT);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+        return false;
+    }
+    if (deviceLost(result)) {
+        return false;
+    }
+    assert(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR);
+
+    // Only reset the fence once work is guaranteed to be submitted
+    vkResetFences(m_logical_device, 1, &m_in_flight_fences[m_current_frame]);
+
+    VkCommandBuffer command_buffer = m_command_buffers[m_current_frame];
+    vkResetCommandPool(m_logical_device, m_command_pools[m_current_frame], 0);
+    m_parallel_recorder.beginFrame(m_current_frame);
+    m_descriptor_allocator.beginFrame(m_current_frame);
+    updateFrameUniforms();
+    recordCommandBuffer(command_buffer, image_index);
+
+    VkSemaphore wait_semaphores[] = {m_image_available_semaphores[m_current_frame]};
+    VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    VkSemaphore signal_semaphores[] = {m_render_finished_semaphores[image_index]};
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = 1;
+    submit_info.pWaitSemaphores = wait_semaphores;
+    submit_info.pWaitDstStageMask = wait_stages;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = signal_semaphores;
+
+    result = vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_in_flight_fences[m_current_frame]);
+    if (deviceLost(result)) {
+        return false;
+    }
+    if (result != VK_SUCCESS) {
+        qDebug() << "Failed to submit draw command buffer: " << result;
+    }
+    assert(result == VK_SUCCESS);
+    m_frame_numbers[m_current_frame] = ++m_submitted_frame_number;
+    reportChannelLoads();
+
+    VkPresentInfoKHR present_info{};
+    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = signal_semaphores;
+    present_info.swapchainCount = 1;
+    present_info.pSwapchains = &m_swap_chain;
+    present_info.pImageIndices = &image_index;
+
+    VkPresentIdKHR present_id_info{};
+    present_id_info.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    present_id_info.swapchainCount = 1;
+    present_id_info.pPresentIds = &present_id;
+    if (present_timing) {
+        present_info.pNext = &present_id_info;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_swap_chain_mutex);
+        result = vkQueuePresentKHR(m_present_queue, &present_info);
+    }
+    if (present_timing && (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+        m_frame_pacer.framePresented(present_id);
+        if (present_id % 240 == 0) {
+            m_frame_pacer.logStatistics();
+        }
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+        m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+    } else if (deviceLost(result)) {
+        return false;
+    } else {
+        assert(result == VK_SUCCESS);
+    }
+
+    m_current_frame = (m_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return true;
+}
+
+void SeVulkanWindow::scheduleUpdate() {
+    if (m_render_scheduler.needsFrame()) {
+        requestUpdate();
+    }
+}
+
+void SeVulkanWindow::markShaderChanged() {
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SHADER);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::markParametersChanged() {
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_PARAMETERS);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setUserParameter(uint32_t index, float value) {
+    assert(index < MAX_USER_PARAMETERS);
+    m_user_parameters[index] = value;
+    markParametersChanged();
+}
+
+void SeVulkanWindow::updateFrameUniforms() {
+    // The frame's fence has signaled, so its segment of the ring is free
+    m_uniform_ring.beginFrame(m_current_frame);
+
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start_time).count();
+    VkExtent2D extent = m_scaled_resource != SeRenderGraph::INVALID_RESOURCE ? m_resolution_scaler.scaledExtent(m_swap_chain_extent) : m_swap_chain_extent;
+
+    FrameUniforms uniforms{};
+    uniforms.resolution[0] = static_cast<float>(extent.width);
+    uniforms.resolution[1] = static_cast<float>(extent.height);
+    uniforms.resolution[2] = 1.0f;
+    std::copy(std::begin(m_mouse), std::end(m_mouse), uniforms.mouse);
+    uniforms.time = static_cast<float>(time);
+    uniforms.time_delta = static_cast<float>(time - m_last_frame_time);
+    uniforms.frame = static_cast<uint32_t>(m_submitted_frame_number);
+    std::copy(std::begin(m_user_parameters), std::end(m_user_parameters), uniforms.parameters);
+    m_last_frame_time = time;
+
+    m_frame_uniform_offset = m_uniform_ring.push(uniforms);
+    assert(m_frame_uniform_offset != SeUniformRing::INVALID_OFFSET);
+
+    // A block set from the CPU is copied into this frame's segment, so it
+    // can change every frame without touching a descriptor
+    if (!m_parameter_block.empty()) {
+        m_parameter_address = m_uniform_ring.pushBlock(m_parameter_block.data(), m_parameter_block.size());
+    } else {
+        m_parameter_address = m_parameter_buffer_address;
+    }
+}
+
+void SeVulkanWindow::setTimeDependent(bool time_dependent) {
+    // Forces continuous rendering on top of what the shader reads
+    m_time_dependent = time_dependent;
+    m_render_scheduler.setTimeDependent(m_time_dependent || m_shader_time_dependent);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setAdaptivePacing(bool enabled) {
+    if (enabled && !m_present_timing_supported) {
+        qDebug() << "Adaptive pacing needs VK_KHR_present_id and VK_KHR_present_wait";
+        return;
+    }
+    m_frame_pacer.setAdaptivePacing(enabled);
+}
+
+void SeVulkanWindow::setSwapChainImageCount(uint32_t image_count) {
+    // 0 returns to the tuned or default image count
+    m_swap_chain_tuner.setImageCountOverride(image_count);
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setParallelRecording(bool enabled) {
+    m_parallel_recording = enabled;
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_PARAMETERS);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::benchmarkParallelRecording() {
+    const uint32_t task_count = 64;
+    const uint32_t draws_per_task = 256;
+    const uint32_t iterations = 20;
+    const uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    vkDeviceWaitIdle(m_logical_device);
+
+    // Records without submitting, so only CPU recording cost is measured
+    std::vector<SeParallelRecorder::RecordFunction> tasks(task_count, [this](VkCommandBuffer command_buffer) {
+        for (uint32_t i = 0; i < draws_per_task; i++) {
+            recordPreview(command_buffer, m_graphics_pipeline, m_swap_chain_extent);
+        }
+    });
+    VkCommandBufferInheritanceRenderingInfoKHR rendering_inheritance{};
+    VkCommandBufferInheritanceInfo inheritance = renderingInheritanceInfo(rendering_inheritance, 0);
+    VkCommandBufferUsageFlags usage_flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+
+    qDebug() << "Parallel recording benchmark:" << task_count << "tasks x" << draws_per_task << "draws";
+    double single_thread_ms = 0.0;
+    for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count++) {
+        m_parallel_recorder.init(m_logical_device, m_queue_family_indices.graphic_family.value(), MAX_FRAMES_IN_FLIGHT, thread_count);
+        m_parallel_recorder.beginFrame(0);
+        m_parallel_recorder.record(inheritance, usage_flags, tasks);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            m_parallel_recorder.beginFrame(i % MAX_FRAMES_IN_FLIGHT);
+            m_parallel_recorder.record(inheritance, usage_flags, tasks);
+        }
+        double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+        if (thread_count == 1) {
+            single_thread_ms = frame_ms;
+        }
+        qDebug() << " threads" << thread_count << ":" << frame_ms << "ms/frame, speedup" << single_thread_ms / frame_ms;
+    }
+
+    m_parallel_recorder.init(m_logical_device, m_queue_family_indices.graphic_family.value(), MAX_FRAMES_IN_FLIGHT);
+}
+
+void SeVulkanWindow::benchmarkCommandPoolReset() {
+    const uint32_t buffers_per_frame = 64;
+    const uint32_t commands_per_buffer = 64;
+    const uint32_t frame_count = 200;
+
+    vkDeviceWaitIdle(m_logical_device);
+
+    VkViewport viewport{0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+    auto recordBuffer = [&](VkCommandBuffer command_buffer) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(command_buffer, &begin_info);
+        for (uint32_t i = 0; i < commands_per_buffer; i++) {
+            vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        }
+        vkEndCommandBuffer(command_buffer);
+    };
+    auto allocateBuffers = [&](VkCommandPool command_pool, std::vector<VkCommandBuffer> &command_buffers) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = command_pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = buffers_per_frame;
+        command_buffers.resize(buffers_per_frame);
+        vkAllocateCommandBuffers(m_logical_device, &alloc_info, command_buffers.data());
+    };
+
+    enum Strategy {
+        FREE_AND_ALLOCATE,
+        RESET_BUFFERS,
+        RESET_POOL
+    };
+    const char *strategy_names[] = {"free and allocate", "reset per buffer", "reset pool"};
+
+    qDebug() << "Command pool benchmark:" << buffers_per_frame << "buffers x" << commands_per_buffer << "commands per frame";
+    for (int strategy = FREE_AND_ALLOCATE; strategy <= RESET_POOL; strategy++) {
+        std::vector<VkCommandPool> command_pools(MAX_FRAMES_IN_FLIGHT);
+        std::vector<std::vector<VkCommandBuffer>> command_buffers(MAX_FRAMES_IN_FLIGHT);
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.flags = strategy == RESET_BUFFERS ? VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT : VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_info.queueFamilyIndex = m_queue_family_indices.graphic_family.value();
+            vkCreateCommandPool(m_logical_device, &pool_info, nullptr, &command_pools[i]);
+            allocateBuffers(command_pools[i], command_buffers[i]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            uint32_t frame_index = frame % MAX_FRAMES_IN_FLIGHT;
+            VkCommandPool command_pool = command_pools[frame_index];
+            std::vector<VkCommandBuffer> &frame_buffers = command_buffers[frame_index];
+            if (strategy == FREE_AND_ALLOCATE) {
+                vkFreeCommandBuffers(m_logical_device, command_pool, buffers_per_frame, frame_buffers.data());
+                allocateBuffers(command_pool, frame_buffers);
+            } else if (strategy == RESET_BUFFERS) {
+                for (auto command_buffer : frame_buffers) {
+                    vkResetCommandBuffer(command_buffer, 0);
+                }
+            } else {
+                vkResetCommandPool(m_logical_device, command_pool, 0);
+            }
+            for (auto command_buffer : frame_buffers) {
+                recordBuffer(command_buffer);
+            }
+        }
+        double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frame_count;
+        qDebug() << " " << strategy_names[strategy] << ":" << frame_ms << "ms/frame";
+
+        for (auto command_pool : command_pools) {
+            vkDestroyCommandPool(m_logical_device, command_pool, nullptr);
+        }
+    }
+}
+
+void SeVulkanWindow::benchmarkDescriptorAllocation() {
+    const uint32_t draws_per_frame = 1024;
+    const uint32_t frame_count = 200;
+
+    vkDeviceWaitIdle(m_logical_device);
+
+    // A typical material: parameters plus two textures
+    std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    SeDescriptorLayoutCache *layout_cache = m_device_context->descriptorLayoutCache();
+    VkDescriptorSetLayout layout = layout_cache->layout(bindings);
+
+    qDebug() << "Descriptor benchmark:" << draws_per_frame << "sets per frame, allocation only";
+
+    // Naive: every draw allocates its own set, which is freed individually
+    // once the frame comes around again
+    {
+        std::vector<VkDescriptorPoolSize> pool_sizes = layout_cache->descriptorCounts(layout);
+        for (auto &pool_size : pool_sizes) {
+            pool_size.descriptorCount *= draws_per_frame * MAX_FRAMES_IN_FLIGHT;
+        }
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        pool_info.maxSets = draws_per_frame * MAX_FRAMES_IN_FLIGHT;
+        pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_info.pPoolSizes = pool_sizes.data();
+        VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+        vkCreateDescriptorPool(m_logical_device, &pool_info, nullptr, &descriptor_pool);
+
+        VkDescriptorSetAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool = descriptor_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &layout;
+
+        std::vector<std::vector<VkDescriptorSet>> frame_sets(MAX_FRAMES_IN_FLIGHT);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            std::vector<VkDescriptorSet> &sets = frame_sets[frame % MAX_FRAMES_IN_FLIGHT];
+            for (auto descriptor_set : sets) {
+                vkFreeDescriptorSets(m_logical_device, descriptor_pool, 1, &descriptor_set);
+            }
+            sets.resize(draws_per_frame);
+            for (uint32_t draw = 0; draw < draws_per_frame; draw++) {
+                vkAllocateDescriptorSets(m_logical_device, &alloc_info, &sets[draw]);
+            }
+        }
+        double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frame_count;
+        qDebug() << "  allocate and free per draw :" << frame_ms << "ms/frame";
+        vkDestroyDescriptorPool(m_logical_device, descriptor_pool, nullptr);
+    }
+
+    {
+        SeDescriptorAllocator descriptor_allocator;
+        descriptor_allocator.init(m_logical_device, layout_cache, MAX_FRAMES_IN_FLIGHT);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            descriptor_allocator.beginFrame(frame % MAX_FRAMES_IN_FLIGHT);
+            for (uint32_t draw = 0; draw < draws_per_frame; draw++) {
+                descriptor_allocator.allocate(layout);
+            }
+        }
+        double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frame_count;
+        qDebug() << "  frame allocator :" << frame_ms << "ms/frame with" << descriptor_allocator.poolCount() << "pools";
+        descriptor_allocator.cleanup();
+    }
+}
+
+void SeVulkanWindow::startSwapChainSweep() {
+    m_swap_chain_tuner.startSweep();
+    updateContinuousRendering();
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setProgressiveAccumulation(bool enabled) {
+    if (enabled && !m_accumulation_supported) {
+        qDebug() << "Progressive accumulation needs dynamic rendering and a blittable swap chain";
+        return;
+    }
+    m_progressive_accumulation = enabled;
+    buildRenderGraph();
+    resetAccumulation();
+    updateContinuousRendering();
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_PARAMETERS);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setTiledRendering(bool enabled) {
+    if (enabled && !m_accumulation_supported) {
+        qDebug() << "Tiled rendering needs dynamic rendering and a blittable swap chain";
+        return;
+    }
+    m_tiled_rendering = enabled;
+    m_tile_scheduler.setTiling(enabled);
+    buildRenderGraph();
+    resetAccumulation();
+    updateContinuousRendering();
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_PARAMETERS);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setBindless(bool enabled) {
+    if (enabled && !m_device_context->isDescriptorIndexingSupported()) {
+        qDebug() << "Bindless mode needs descriptor indexing with update after bind";
+        return;
+    }
+    if (enabled == m_bindless) {
+        return;
+    }
+    m_bindless = enabled;
+    if (enabled && !m_bindless_table.isInitialized()) {
+        m_bindless_table.init(m_logical_device, m_device_context->descriptorLayoutCache(), &m_deletion_queue, m_device_context->descriptorIndexingProperties());
+    }
+    // The pipeline layout gains or loses the table's set
+    replaceGraphicsPipeline(false);
+    markShaderChanged();
+}
+
+void SeVulkanWindow::setChannel(uint32_t channel, SeBindlessTable::Handle handle) {
+    assert(channel < MAX_CHANNELS);
+    m_channels[channel] = handle;
+    markParametersChanged();
+}
+
+void SeVulkanWindow::loadChannel(uint32_t channel, const QString &path, bool srgb) {
+    assert(channel < MAX_CHANNELS);
+    if (!m_bindless_table.isInitialized()) {
+        qDebug() << "Texture channels need bindless mode";
+        return;
+    }
+    ChannelSource &source = m_channel_sources[channel];
+    if (source.pending_texture != SeTextureLoader::INVALID_TEXTURE) {
+        m_texture_loader.release(source.pending_texture, m_submitted_frame_number);
+    }
+    source.path = path;
+    source.srgb = srgb;
+    source.pending_texture = m_texture_loader.load(path, srgb);
+    if (!m_channel_load_timing) {
+        m_channel_load_start = std::chrono::steady_clock::now();
+        m_channel_load_timing = true;
+    }
+    // Frames keep coming while the textures decode and upload
+    updateContinuousRendering();
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::loadChannels(const QStringList &paths) {
+    // All decodes are queued at once and run side by side on the pool
+    assert(paths.size() <= static_cast<qsizetype>(MAX_CHANNELS));
+    m_channel_load_timing = false;
+    for (qsizetype i = 0; i < paths.size(); i++) {
+        if (!paths[i].isEmpty()) {
+            loadChannel(static_cast<uint32_t>(i), paths[i]);
+        }
+    }
+}
+
+void SeVulkanWindow::reloadChannels() {
+    m_channel_load_timing = false;
+    for (uint32_t i = 0; i < MAX_CHANNELS; i++) {
+        if (!m_channel_sources[i].path.isEmpty()) {
+            loadChannel(i, m_channel_sources[i].path, m_channel_sources[i].srgb);
+        }
+    }
+}
+
+void SeVulkanWindow::bindLoadedChannels(const std::vector<SeTextureLoader::TextureHandle> &ready_textures) {
+    // Called while recording, after the mip chains of the ready textures,
+    // so the frame being recorded is the first one to sample them
+    for (uint32_t i = 0; i < MAX_CHANNELS; i++) {
+        ChannelSource &source = m_channel_sources[i];
+        if (std::find(ready_textures.begin(), ready_textures.end(), source.pending_texture) == ready_textures.end()) {
+            continue;
+        }
+        if (source.bound_texture != SeTextureLoader::INVALID_TEXTURE) {
+            m_bindless_table.removeImage(source.slot, m_submitted_frame_number);
+            m_texture_loader.release(source.bound_texture, m_submitted_frame_number);
+        }
+        source.bound_texture = source.pending_texture;
+        source.pending_texture = SeTextureLoader::INVALID_TEXTURE;
+        source.slot = m_bindless_table.addImage(m_texture_loader.view(source.bound_texture), m_texture_loader.sampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        m_channels[i] = source.slot;
+    }
+    // The next frame restarts accumulation with the new inputs
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_PARAMETERS);
+}
+
+void SeVulkanWindow::reportChannelLoads() {
+    if (!m_channel_load_timing) {
+        return;
+    }
+    for (auto &source : m_channel_sources) {
+        if (source.pending_texture == SeTextureLoader::INVALID_TEXTURE) {
+            continue;
+        }
+        if (!m_texture_loader.hasFailed(source.pending_texture)) {
+            return;
+        }
+        m_texture_loader.release(source.pending_texture, m_submitted_frame_number);
+        source.pending_texture = SeTextureLoader::INVALID_TEXTURE;
+    }
+    double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_channel_load_start).count();
+    qDebug() << "Channels loaded, first frame using them submitted after" << latency_ms << "ms";
+    m_channel_load_timing = false;
+}
+
+void SeVulkanWindow::setParameterBlock(const void *data, size_t size) {
+    if (!m_uniform_ring.supportsBlocks()) {
+        qDebug() << "Parameter blocks need buffer device address";
+        return;
+    }
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    m_parameter_block.assign(bytes, bytes + size);
+    markParametersChanged();
+}
+
+void SeVulkanWindow::setParameterAddress(VkDeviceAddress address) {
+    // For large device local inputs from the memory allocator, created with
+    // VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT and kept alive by the caller
+    if (!m_uniform_ring.supportsBlocks()) {
+        qDebug() << "Parameter blocks need buffer device address";
+        return;
+    }
+    m_parameter_block.clear();
+    m_parameter_buffer_address = address;
+    markParametersChanged();
+}
+
+void SeVulkanWindow::setTileBudget(double budget_ms) {
+    m_tile_scheduler.setBudgetMs(budget_ms);
+}
+
+void SeVulkanWindow::setDynamicResolution(bool enabled) {
+    if (enabled && !m_dynamic_resolution_supported) {
+        qDebug() << "Dynamic resolution needs dynamic rendering and a blittable swap chain";
+        return;
+    }
+    if (enabled && (m_progressive_accumulation || m_tiled_rendering)) {
+        qDebug() << "Dynamic resolution is ignored while accumulating or tiling";
+    }
+    m_dynamic_resolution = enabled;
+    m_resolution_scaler.reset();
+    buildRenderGraph();
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_PARAMETERS);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::setSampleCount(uint32_t sample_count) {
+    // The highest supported count up to the requested one
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(m_best_physical_device, &device_properties);
+    VkSampleCountFlags supported_counts = device_properties.limits.framebufferColorSampleCounts;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    for (uint32_t count = 2; count <= std::min(sample_count, 64u); count *= 2) {
+        if (supported_counts & count) {
+            samples = static_cast<VkSampleCountFlagBits>(count);
+        }
+    }
+    if (samples == m_sample_count) {
+        return;
+    }
+    m_sample_count = samples;
+    qDebug() << "Preview sample count set to" << m_sample_count;
+
+    // Attachment counts change, so the pass, the pipelines drawing in it
+    // and the framebuffers are all replaced
+    retireFramebuffers();
+    replaceGraphicsPipeline(true);
+    createFramebuffers();
+    markShaderChanged();
+}
+
+void SeVulkanWindow::setTargetFrameTime(double target_ms) {
+    m_resolution_scaler.setTargetFrameTimeMs(target_ms);
+}
+
+void SeVulkanWindow::updateTitle() {
+    if (m_scaled_resource != SeRenderGraph::INVALID_RESOURCE) {
+        setTitle(QString("ShaderEditor (render scale %1%)").arg(qRound(m_resolution_scaler.scale() * 100.0f)));
+    } else {
+        setTitle("ShaderEditor");
+    }
+}
+
+void SeVulkanWindow::updateContinuousRendering() {
+    // Keep drawing while a sweep measures, the accumulation converges or
+    // the tiles of the current image are still being filled in, and until
+    // every requested texture has been decoded and uploaded
+    bool converging = m_progressive_accumulation && m_accumulated_samples < MAX_ACCUMULATED_SAMPLES;
+    bool filling_tiles = m_tiled_rendering && m_tile_scheduler.isSweepInProgress();
+    m_render_scheduler.setContinuous(m_swap_chain_tuner.isSweeping() || converging || filling_tiles || m_texture_loader.isBusy());
+}
+
+bool SeVulkanWindow::deviceLost(VkResult result) {
+    if (result != VK_ERROR_DEVICE_LOST) {
+        return false;
+    }
+    // Recovery happens outside the frame, nothing of it can be salvaged
+    qDebug() << "Device lost, probably a shader exceeded the GPU timeout";
+    m_device_lost = true;
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_ALL);
+    // The device is shared, so every other window is affected as well
+    m_device_context->markDeviceLost();
+    return true;
+}
+
+void SeVulkanWindow::recoverFromDeviceLost() {
+    if (m_device_context) {
+        // The other windows on the device released their objects when it was
+        // lost, so this drops the last reference to it
+        cleanup();
+    }
+    m_device_lost = false;
+    init();
+    // The channel textures went with the device, decode them again
+    reloadChannels();
+
+    // The shader that hung the GPU is most likely still loaded, so continue
+    // in small tiles that stay under the timeout
+    qDebug() << "Device recreated";
+    m_tile_scheduler.resetBudget();
+    if (m_accumulation_supported && !m_tiled_rendering) {
+        setTiledRendering(true);
+    }
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_ALL);
+    scheduleUpdate();
+}
+
+#pragma endregion Frame loop
+
+#pragma region Window events
+void SeVulkanWindow::exposeEvent(QExposeEvent *event) {
+    Q_UNUSED(event);
+    // A minimized or fully hidden window is reported as not exposed
+    m_render_scheduler.setVisible(isExposed());
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::resizeEvent(QResizeEvent *event) {
+    Q_UNUSED(event);
+    m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+    scheduleUpdate();
+}
+
+void SeVulkanWindow::mousePressEvent(QMouseEvent *event) {
+    // Shadertoy convention: xy follow the pointer while a button is held,
+    // zw keep where it was pressed, in pixels
+    qreal ratio = devicePixelRatio();
+    m_mouse[0] = m_mouse[2] = static_cast<float>(event->position().x() * ratio);
+    m_mouse[1] = m_mouse[3] = static_cast<float>(event->position().y() * ratio);
+    markParametersChanged();
+}
+
+void SeVulkanWindow::mouseMoveEvent(QMouseEvent *event) {
+    if (event->buttons() == Qt::NoButton) {
+        return;
+    }
+    qreal ratio = devicePixelRatio();
+    m_mouse[0] = static_cast<float>(event->position().x() * ratio);
+    m_mouse[1] = static_cast<float>(event->position().y() * ratio);
+    markParametersChanged();
+}
+
+bool SeVulkanWindow::event(QEvent *event) {
+    if (event->type() != QEvent::UpdateRequest) {
+        return QWindow::event(event);
+    }
+
+    if (m_device_lost) {
+        recoverFromDeviceLost();
+        return true;
+    }
+
+    if (!m_render_scheduler.needsFrame() || m_swap_chain == VK_NULL_HANDLE) {
+        m_render_scheduler.frameSkipped();
+        return true;
+    }
+
+    uint32_t dirty_flags = m_render_scheduler.takeDirtyFlags();
+    if (dirty_flags & SeRenderScheduler::DIRTY_SWAP_CHAIN) {
+        recreateSwapChain();
+    }
+    if (dirty_flags & (SeRenderScheduler::DIRTY_SWAP_CHAIN | SeRenderScheduler::DIRTY_SHADER | SeRenderScheduler::DIRTY_PARAMETERS)) {
+        // Any change to what the shader computes restarts the average
+        resetAccumulation();
+    }
+    if (drawFrame()) {
+        m_render_scheduler.frameRendered();
+        if (m_swap_chain_tuner.isSweeping()) {
+            double latency_ms = m_frame_pacer.isRunning() ? m_frame_pacer.averageLatencyMs() : 0.0;
+            if (m_swap_chain_tuner.recordFrame(latency_ms)) {
+                m_render_scheduler.markDirty(SeRenderScheduler::DIRTY_SWAP_CHAIN);
+            }
+        }
+        updateContinuousRendering();
+    }
+
+    // Continuous redraw only while the shader animates or a frame was dropped
+    scheduleUpdate();
+    return true;
+}
+
+#pragma endregion Window events
@@ -1,8 +1,24 @@
 #ifndef SE_VULKAN_WINDOW_H
 #define SE_VULKAN_WINDOW_H
+#include "SeBindlessTable.h"
+#include "SeDeletionQueue.h"
+#include "SeDescriptorAllocator.h"
+#include "SeFramePacer.h"
+#include "SeParallelRecorder.h"
+#include "SeRenderGraph.h"
+#include "SeRenderScheduler.h"
+#include "SeResolutionScaler.h"
+#include "SeResourceStateTracker.h"
+#include "SeSwapChainTuner.h"
+#include "SeTextureLoader.h"
+#include "SeTileScheduler.h"
+#include "SeUniformRing.h"
 #include "SeVulkanManager.h"
 #include <QScopedPointer>
+#include <QStringList>
 #include <QWindow>
+#include <chrono>
+#include <mutex>
 
 class SeVulkanWindowPrivate;
 class SeVulkanWindow : public QWindow {
@@ -13,13 +29,92 @@ class SeVulkanWindow : public QWindow {
     ~SeVulkanWindow();
     void init();
     void cleanup();
+    bool hasDevice() const;
+
+    void reloadShaders();
+    void markShaderChanged();
+    void markParametersChanged();
+    void setUserParameter(uint32_t index, float value);
+    void setTimeDependent(bool time_dependent);
+    void setAdaptivePacing(bool enabled);
+    void setSwapChainImageCount(uint32_t image_count);
+    void startSwapChainSweep();
+    void setProgressiveAccumulation(bool enabled);
+    void setTiledRendering(bool enabled);
+    void setTileBudget(double budget_ms);
+    void setDynamicResolution(bool enabled);
+    void setSampleCount(uint32_t sample_count);
+    void setBindless(bool enabled);
+    void setChannel(uint32_t channel, SeBindlessTable::Handle handle);
+    void loadChannel(uint32_t channel, const QString &path, bool srgb = true);
+    void loadChannels(const QStringList &paths);
+    void setParameterBlock(const void *data, size_t size);
+    void setParameterAddress(VkDeviceAddress address);
+    void setTargetFrameTime(double target_ms);
+    void setParallelRecording(bool enabled);
+    void benchmarkParallelRecording();
+    void benchmarkCommandPoolReset();
+    void benchmarkDescriptorAllocation();
+
+  protected:
+    void exposeEvent(QExposeEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    bool event(QEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
 
   private:
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+    static constexpr uint32_t MAX_ACCUMULATED_SAMPLES = 4096;
+    static constexpr uint32_t MAX_USER_PARAMETERS = 8;
+    static constexpr uint32_t MAX_CHANNELS = 4;
+    static constexpr uint64_t ACQUIRE_SLICE_NS = 250000;
+
+    // Fragment push constants: the accumulated sample index, in bindless
+    // mode the table handles of the Shadertoy style input channels, and the
+    // device address of the parameter block, 0 without one
+    struct PushConstants {
+        uint32_t accumulated_samples;
+        uint32_t channels[MAX_CHANNELS];
+        VkDeviceAddress parameters;
+    };
+
+    // Shadertoy style inputs in the std140 layout of the uniform block at
+    // set 0, binding 0. The parameters are read as vec4[2] in the shader.
+    // Reading members 2 to 4 makes a shader time dependent
+    struct FrameUniforms {
+        float resolution[4];
+        float mouse[4];
+        float time;
+        float time_delta;
+        uint32_t frame;
+        uint32_t padding;
+        float parameters[MAX_USER_PARAMETERS];
+    };
+
+    // An image file feeding a channel. The bound texture stays in use until
+    // the one loading to replace it is ready
+    struct ChannelSource {
+        QString path;
+        bool srgb = true;
+        SeTextureLoader::TextureHandle pending_texture = SeTextureLoader::INVALID_TEXTURE;
+        SeTextureLoader::TextureHandle bound_texture = SeTextureLoader::INVALID_TEXTURE;
+        SeBindlessTable::Handle slot = SeBindlessTable::INVALID_HANDLE;
+    };
+
+    // An attachment whose contents never leave the render pass, such as the
+    // multisampled color target that is resolved into the swap chain image
+    struct TransientAttachment {
+        VkImage image = VK_NULL_HANDLE;
+        SeMemoryAllocator::Allocation allocation;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
     void createSurface();
     void destroySurface();
 
-    void createLogicalDevice();
-    void destoryLogicalDevice();
+    bool acquireDeviceContext();
+    void releaseDeviceContext();
 
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &available_formats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &available_present_modes);
@@ -35,33 +130,157 @@ class SeVulkanWindow : public QWindow {
 
     void createGraphicsPipeline();
     void destroyGraphicsPipeline();
+    void replaceGraphicsPipeline(bool replace_render_pass);
     VkShaderModule createShaderModule(std::vector<char> code);
 
-    const std::vector<const char *> m_device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    void createFramebuffers();
+    void destroyFramebuffers();
+    void retireFramebuffers();
+    void createTransientAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, TransientAttachment &attachment);
+    void destroyTransientAttachment(TransientAttachment &attachment);
+
+    void createCommandPools();
+    void destroyCommandPools();
+    void createCommandBuffers();
+
+    void createSyncObjects();
+    void destroySyncObjects();
+    uint64_t pollCompletedFrames();
+    void createRenderFinishedSemaphores();
+    void destroyRenderFinishedSemaphores();
+
+    void createTimestampQueries();
+    void destroyTimestampQueries();
+    void readTimestamps(uint32_t frame_index);
+
+    void recreateSwapChain();
+    void updateFrameUniforms();
+    void recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index);
+    void recordPreview(VkCommandBuffer command_buffer, VkPipeline pipeline, VkExtent2D extent) const;
+    VkCommandBufferInheritanceInfo renderingInheritanceInfo(VkCommandBufferInheritanceRenderingInfoKHR &rendering_inheritance, uint32_t image_index) const;
+    void beginRendering(VkCommandBuffer command_buffer, uint32_t image_index, bool secondary_contents);
+    void endRendering(VkCommandBuffer command_buffer);
+    void buildRenderGraph();
+    void recordRenderGraph(VkCommandBuffer command_buffer, uint32_t image_index);
+    void recordTiles(VkCommandBuffer command_buffer) const;
+    void bindLoadedChannels(const std::vector<SeTextureLoader::TextureHandle> &ready_textures);
+    void reportChannelLoads();
+    void reloadChannels();
+    void bindFrameResources(VkCommandBuffer command_buffer) const;
+    void blitToSwapChain(VkCommandBuffer command_buffer, VkImage source_image, VkExtent2D source_extent, VkImage swap_chain_image, VkFilter filter);
+    void chooseAccumulationFormat(bool transfer_dst_supported);
+    void checkDynamicResolutionSupport(bool transfer_dst_supported);
+    void resetAccumulation();
+    void updateContinuousRendering();
+    void updateTitle();
+    bool deviceLost(VkResult result);
+    void recoverFromDeviceLost();
+    bool drawFrame();
+    void scheduleUpdate();
 
     SeVulkanManager *m_vulkan_manager = nullptr;
+    SeDeviceContext *m_device_context = nullptr;
 
     VkPhysicalDevice m_best_physical_device = VK_NULL_HANDLE;
 
     VkSurfaceKHR m_surface = VK_NULL_HANDLE;
 
     VkDevice m_logical_device = VK_NULL_HANDLE;
+    SeQueueFamilyIndices m_queue_family_indices;
     VkQueue m_graphics_queue = VK_NULL_HANDLE;
     VkQueue m_present_queue = VK_NULL_HANDLE;
 
+    bool m_dynamic_rendering_supported = false;
+    PFN_vkCmdBeginRenderingKHR m_vkCmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR m_vkCmdEndRendering = nullptr;
+    SeResourceStateTracker m_state_tracker;
+    SeRenderGraph m_render_graph;
+    SeRenderGraph::ResourceHandle m_backbuffer_resource = SeRenderGraph::INVALID_RESOURCE;
+    // The pass drawing the preview with the graphics pipeline, multisampled
+    // with m_sample_count; history rendering has none
+    SeRenderGraph::PassHandle m_image_pass = SeRenderGraph::INVALID_PASS;
+
+    bool m_accumulation_supported = false;
+    bool m_progressive_accumulation = false;
+    VkFormat m_accumulation_format = VK_FORMAT_UNDEFINED;
+    SeRenderGraph::ResourceHandle m_accumulation_resource = SeRenderGraph::INVALID_RESOURCE;
+    uint32_t m_accumulated_samples = 0;
+    bool m_tiled_rendering = false;
+    SeTileScheduler m_tile_scheduler;
+    SeTileScheduler::Batch m_tile_batch;
+    bool m_dynamic_resolution_supported = false;
+    bool m_dynamic_resolution = false;
+    SeResolutionScaler m_resolution_scaler;
+    SeRenderGraph::ResourceHandle m_scaled_resource = SeRenderGraph::INVALID_RESOURCE;
+    VkExtent2D m_render_extent = {0, 0};
+
+    VkQueryPool m_timestamp_query_pool = VK_NULL_HANDLE;
+    float m_timestamp_period = 0.0f;
+    std::vector<uint32_t> m_frame_timed_tiles;
+
     VkSwapchainKHR m_swap_chain = VK_NULL_HANDLE;
     std::vector<VkImage> m_swap_chain_images;
     VkFormat m_swap_chain_image_format;
     VkExtent2D m_swap_chain_extent;
+    VkPresentModeKHR m_swap_chain_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    SeSwapChainTuner m_swap_chain_tuner;
 
     std::vector<VkImageView> m_swap_chain_image_views;
 
     VkRenderPass m_render_pass = VK_NULL_HANDLE;
+    VkSampleCountFlagBits m_sample_count = VK_SAMPLE_COUNT_1_BIT;
+    TransientAttachment m_msaa_attachment;
 
     VkShaderModule m_vert_shader_module = VK_NULL_HANDLE;
     VkShaderModule m_frag_shader_module = VK_NULL_HANDLE;
     VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
     VkPipeline m_graphics_pipeline = VK_NULL_HANDLE;
+    VkPipeline m_accumulation_pipeline = VK_NULL_HANDLE;
+
+    std::vector<VkFramebuffer> m_swap_chain_framebuffers;
+
+    SeUniformRing m_uniform_ring;
+    SeDescriptorAllocator m_descriptor_allocator;
+    uint32_t m_frame_uniform_offset = 0;
+    std::chrono::steady_clock::time_point m_start_time;
+    double m_last_frame_time = 0.0;
+    float m_mouse[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float m_user_parameters[MAX_USER_PARAMETERS] = {};
+
+    bool m_bindless = false;
+    SeBindlessTable m_bindless_table;
+    uint32_t m_channels[MAX_CHANNELS] = {SeBindlessTable::INVALID_HANDLE, SeBindlessTable::INVALID_HANDLE, SeBindlessTable::INVALID_HANDLE, SeBindlessTable::INVALID_HANDLE};
+    std::vector<uint8_t> m_parameter_block;
+    VkDeviceAddress m_parameter_buffer_address = 0;
+    VkDeviceAddress m_parameter_address = 0;
+    SeTextureLoader m_texture_loader;
+    ChannelSource m_channel_sources[MAX_CHANNELS];
+    std::chrono::steady_clock::time_point m_channel_load_start;
+    bool m_channel_load_timing = false;
+
+    std::vector<VkCommandPool> m_command_pools;
+    std::vector<VkCommandBuffer> m_command_buffers;
+    SeParallelRecorder m_parallel_recorder;
+    bool m_parallel_recording = false;
+
+    std::vector<VkSemaphore> m_image_available_semaphores;
+    std::vector<VkSemaphore> m_render_finished_semaphores;
+    std::vector<VkFence> m_in_flight_fences;
+    uint32_t m_current_frame = 0;
+    std::vector<uint64_t> m_frame_numbers;
+    uint64_t m_submitted_frame_number = 0;
+    uint64_t m_completed_frame_number = 0;
+    SeDeletionQueue m_deletion_queue;
+    bool m_device_lost = false;
+
+    bool m_present_timing_supported = false;
+    PFN_vkWaitForPresentKHR m_vkWaitForPresentKHR = nullptr;
+    std::mutex m_swap_chain_mutex;
+    SeFramePacer m_frame_pacer;
+
+    SeRenderScheduler m_render_scheduler;
+    bool m_time_dependent = false;
+    bool m_shader_time_dependent = false;
 };
 
 #endif
\ No newline at end of file
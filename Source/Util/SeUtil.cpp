@@ -1,5 +1,9 @@
 #include "SeUtil.h"
 #include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
 #include <fstream>
 #include <iostream>
 
@@ -17,4 +21,76 @@ std::vector<char> SeUtil::readFile(const std::string &file_name) {
     file.close();
 
     return buffer;
-}
\ No newline at end of file
+}
+
+bool SeUtil::readsBlockMembers(const std::vector<char> &code, uint32_t set, uint32_t binding, const std::vector<uint32_t> &members) {
+    std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), code.data(), words.size() * sizeof(uint32_t));
+    if (words.size() < SPIRV_HEADER_WORDS || words[0] != SPIRV_MAGIC) {
+        // Unknown code is assumed to read everything
+        return true;
+    }
+
+    // First pass: the variables decorated with the set and binding, and
+    // the values of integer constants used as member indices
+    std::map<uint32_t, uint32_t> variable_sets;
+    std::map<uint32_t, uint32_t> variable_bindings;
+    std::map<uint32_t, uint32_t> constants;
+    for (size_t i = SPIRV_HEADER_WORDS; i < words.size();) {
+        uint32_t word_count = words[i] >> 16;
+        uint32_t opcode = words[i] & 0xFFFF;
+        if (word_count == 0 || i + word_count > words.size()) {
+            return true;
+        }
+        if (opcode == OP_DECORATE && word_count >= 4 && words[i + 2] == DECORATION_DESCRIPTOR_SET) {
+            variable_sets[words[i + 1]] = words[i + 3];
+        } else if (opcode == OP_DECORATE && word_count >= 4 && words[i + 2] == DECORATION_BINDING) {
+            variable_bindings[words[i + 1]] = words[i + 3];
+        } else if (opcode == OP_CONSTANT && word_count == 4) {
+            constants[words[i + 2]] = words[i + 3];
+        }
+        i += word_count;
+    }
+    std::set<uint32_t> variables;
+    for (const auto &[variable, variable_set] : variable_sets) {
+        auto itr = variable_bindings.find(variable);
+        if (variable_set == set && itr != variable_bindings.end() && itr->second == binding) {
+            variables.insert(variable);
+        }
+    }
+    if (variables.empty()) {
+        return false;
+    }
+
+    // Second pass: every instruction that takes the block as an operand
+    auto readsMember = [&members](uint32_t member) { return std::find(members.begin(), members.end(), member) != members.end(); };
+    for (size_t i = SPIRV_HEADER_WORDS; i < words.size();) {
+        uint32_t word_count = words[i] >> 16;
+        uint32_t opcode = words[i] & 0xFFFF;
+        bool access_chain = (opcode >= OP_ACCESS_CHAIN && opcode <= OP_PTR_ACCESS_CHAIN) || opcode == OP_IN_BOUNDS_PTR_ACCESS_CHAIN;
+        if (access_chain && word_count >= 4 && variables.count(words[i + 3]) > 0) {
+            // A pointer access chain has an element index before the member
+            bool ptr_access_chain = opcode == OP_PTR_ACCESS_CHAIN || opcode == OP_IN_BOUNDS_PTR_ACCESS_CHAIN;
+            size_t index = i + (ptr_access_chain ? 5 : 4);
+            if (index >= i + word_count) {
+                return true;
+            }
+            auto constant = constants.find(words[index]);
+            if (constant == constants.end() || readsMember(constant->second)) {
+                return true;
+            }
+        } else if (opcode == OP_LOAD && word_count >= 4 && variables.count(words[i + 3]) > 0) {
+            return true;
+        } else if (opcode == OP_COPY_MEMORY && word_count >= 3 && variables.count(words[i + 2]) > 0) {
+            return true;
+        } else if (opcode == OP_FUNCTION_CALL) {
+            for (uint32_t j = 4; j < word_count; j++) {
+                if (variables.count(words[i + j]) > 0) {
+                    return true;
+                }
+            }
+        }
+        i += word_count;
+    }
+    return false;
+}
@@ -1,12 +1,31 @@
 #ifndef SE_UTIL_H
 #define SE_UTIL_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 class SeUtil {
   public:
     static std::vector<char> readFile(const std::string &file_name);
+    // Whether SPIR-V code may read one of the given members of the block at
+    // set and binding. Any use that is not a constant member access, such as
+    // loading the whole block, counts as reading every member
+    static bool readsBlockMembers(const std::vector<char> &code, uint32_t set, uint32_t binding, const std::vector<uint32_t> &members);
+
+  private:
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+    static constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+    static constexpr uint32_t OP_CONSTANT = 43;
+    static constexpr uint32_t OP_FUNCTION_CALL = 57;
+    static constexpr uint32_t OP_LOAD = 61;
+    static constexpr uint32_t OP_COPY_MEMORY = 63;
+    static constexpr uint32_t OP_ACCESS_CHAIN = 65;
+    static constexpr uint32_t OP_PTR_ACCESS_CHAIN = 67;
+    static constexpr uint32_t OP_IN_BOUNDS_PTR_ACCESS_CHAIN = 70;
+    static constexpr uint32_t OP_DECORATE = 71;
+    static constexpr uint32_t DECORATION_BINDING = 33;
+    static constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
 };
 
 #endif
\ No newline at end of file
@@ -10,6 +10,63 @@ int main(int argc, char *argv[]) {
     vulkan_manager.init();
 
     SeVulkanWindow vulkan_window(nullptr, &vulkan_manager);
+    if (!vulkan_window.hasDevice()) {
+        // No GPU can present to the window, the reason is in the log
+        return 1;
+    }
+    if (app.arguments().contains("--time-dependent")) {
+        // Shaders reading time are detected, this covers everything else
+        vulkan_window.setTimeDependent(true);
+    }
+    if (app.arguments().contains("--adaptive-pacing")) {
+        vulkan_window.setAdaptivePacing(true);
+    }
+    if (app.arguments().contains("--swapchain-sweep")) {
+        // Measures every legal image count and persists the best one
+        vulkan_window.startSwapChainSweep();
+    }
+    if (app.arguments().contains("--parallel-recording")) {
+        vulkan_window.setParallelRecording(true);
+    }
+    if (app.arguments().contains("--progressive-accumulation")) {
+        vulkan_window.setProgressiveAccumulation(true);
+    }
+    if (app.arguments().contains("--tiled-rendering")) {
+        vulkan_window.setTiledRendering(true);
+    }
+    if (app.arguments().contains("--dynamic-resolution")) {
+        vulkan_window.setDynamicResolution(true);
+    }
+    if (app.arguments().contains("--bindless")) {
+        vulkan_window.setBindless(true);
+    }
+    int msaa_index = app.arguments().indexOf("--msaa");
+    if (msaa_index >= 0 && msaa_index + 1 < app.arguments().size()) {
+        // --msaa <samples>
+        vulkan_window.setSampleCount(app.arguments()[msaa_index + 1].toUInt());
+    }
+    int tint_index = app.arguments().indexOf("--tint");
+    if (tint_index >= 0 && tint_index + 3 < app.arguments().size()) {
+        // --tint <r> <g> <b>, the ParameterBlock of the fragment shader
+        float tint[4] = {app.arguments()[tint_index + 1].toFloat(), app.arguments()[tint_index + 2].toFloat(), app.arguments()[tint_index + 3].toFloat(), 1.0f};
+        vulkan_window.setParameterBlock(tint, sizeof(tint));
+    }
+    QStringList channel_paths;
+    for (int i = 0; i < 4; i++) {
+        // --channel0 <image> up to --channel3 <image>
+        int index = app.arguments().indexOf(QString("--channel%1").arg(i));
+        channel_paths << (index >= 0 && index + 1 < app.arguments().size() ? app.arguments()[index + 1] : QString());
+    }
+    vulkan_window.loadChannels(channel_paths);
+    if (app.arguments().contains("--benchmark-recording")) {
+        vulkan_window.benchmarkParallelRecording();
+    }
+    if (app.arguments().contains("--benchmark-command-pools")) {
+        vulkan_window.benchmarkCommandPoolReset();
+    }
+    if (app.arguments().contains("--benchmark-descriptors")) {
+        vulkan_window.benchmarkDescriptorAllocation();
+    }
     vulkan_window.show();
 
     return app.exec();